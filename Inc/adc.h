@@ -46,6 +46,7 @@
 /* USER CODE END Includes */
 
 extern ADC_HandleTypeDef hadc1;
+extern ADC_HandleTypeDef hadc2; // MX: added
 
 /* USER CODE BEGIN Private defines */
 
@@ -54,6 +55,7 @@ extern ADC_HandleTypeDef hadc1;
 extern void Error_Handler(void);
 
 void MX_ADC1_Init(void);
+void MX_ADC2_Init(void); // MX: added
 
 /* USER CODE BEGIN Prototypes */
 
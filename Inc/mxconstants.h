@@ -43,6 +43,8 @@
 
 #define SPI1_CS_Pin GPIO_PIN_6
 #define SPI1_CS_GPIO_Port GPIOE
+#define AUDIO_IN2_Pin GPIO_PIN_0 // MX: added, right channel
+#define AUDIO_IN2_GPIO_Port GPIOB
 #define AUDIO_IN_Pin GPIO_PIN_1
 #define AUDIO_IN_GPIO_Port GPIOB
 #define AUDIO_NSTBY_Pin GPIO_PIN_2
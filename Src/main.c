@@ -82,6 +82,7 @@ int main(void)
   MX_GPIO_Init();
   MX_DMA_Init();
   MX_ADC1_Init();
+  MX_ADC2_Init(); // MX: added
   MX_SPI1_Init();
   MX_TIM3_Init();
   MX_USART1_UART_Init();
@@ -0,0 +1,69 @@
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+#include <user_main.h>
+#include "arena.h"
+
+// Region boundaries, defined in the linker script
+extern uint8_t _sarena;
+extern uint8_t _earena;
+
+/** Allocation granularity */
+#define ARENA_ALIGN 8
+
+/** Offset of the first free byte */
+static size_t arena_top = 0;
+
+/** Set when init is done */
+static bool arena_sealed = false;
+
+
+void *arena_alloc_do(size_t size, const char* file, uint32_t line)
+{
+	if (arena_sealed) {
+		user_error_file_line("Arena alloc after init", file, line);
+	}
+
+	size = (size + ARENA_ALIGN - 1) & ~(size_t) (ARENA_ALIGN - 1);
+
+	if (size > arena_size() - arena_top) {
+		user_error_file_line("Arena full", file, line);
+	}
+
+	void *mem = &_sarena + arena_top;
+	arena_top += size;
+
+	return mem;
+}
+
+
+void *arena_calloc_do(size_t nmemb, size_t size, const char* file, uint32_t line)
+{
+	if (size != 0 && nmemb > SIZE_MAX / size) {
+		user_error_file_line("Arena alloc too large", file, line);
+	}
+
+	// the arena is NOLOAD, not cleared by the startup code
+	void *mem = arena_alloc_do(nmemb * size, file, line);
+	memset(mem, 0, nmemb * size);
+
+	return mem;
+}
+
+
+void arena_seal(void)
+{
+	arena_sealed = true;
+}
+
+
+size_t arena_used(void)
+{
+	return arena_top;
+}
+
+
+size_t arena_size(void)
+{
+	return (size_t) (&_earena - &_sarena);
+}
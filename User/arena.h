@@ -0,0 +1,31 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+/**
+ * Static arena (bump) allocator for init-time allocations.
+ *
+ * Memory is taken from a RAM region reserved in the linker script
+ * (_Arena_Size), it is never freed. Running out of the arena, or
+ * allocating after arena_seal(), is a fatal error.
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include "stm32f1xx_hal.h"
+
+void *arena_alloc_do(size_t size, const char* file, uint32_t line);
+void *arena_calloc_do(size_t nmemb, size_t size, const char* file, uint32_t line);
+
+#define arena_alloc(size)         arena_alloc_do(size,         __FILE__, __LINE__)
+#define arena_calloc(nmemb, size) arena_calloc_do(nmemb, size, __FILE__, __LINE__)
+
+/** Forbid further allocations - call when init is done */
+void arena_seal(void);
+
+/** Get number of bytes taken from the arena (high-water mark - nothing is freed) */
+size_t arena_used(void);
+
+/** Get the arena capacity */
+size_t arena_size(void);
+
+#endif // ARENA_H
@@ -0,0 +1,44 @@
+#include <math.h>
+#include "bands.h"
+
+/** Bin index of each band's lower edge; the last entry is the end of the last band */
+static uint16_t band_edges[BAND_COUNT + 1];
+
+
+void bands_configure(float sample_rate, uint32_t fft_len)
+{
+	const float bin_hz = sample_rate / fft_len;
+	const uint32_t max_bin = fft_len / 2;
+
+	float f_max = sample_rate * 0.45f;
+	if (f_max > BAND_FREQ_MAX) f_max = BAND_FREQ_MAX;
+
+	const float ratio = powf(f_max / BAND_FREQ_MIN, 1.0f / BAND_COUNT);
+
+	float f = BAND_FREQ_MIN;
+	uint32_t prev = 0;
+	for (int i = 0; i <= BAND_COUNT; i++, f *= ratio) {
+		uint32_t bin = (uint32_t) lroundf(f / bin_hz);
+
+		// skip DC, give each band at least one bin
+		if (bin <= prev) bin = prev + 1;
+		if (bin > max_bin) bin = max_bin;
+
+		band_edges[i] = (uint16_t) bin;
+		prev = bin;
+	}
+}
+
+
+void bands_compute(const float *bins, float *levels)
+{
+	for (int i = 0; i < BAND_COUNT; i++) {
+		float peak = 0;
+
+		for (uint32_t b = band_edges[i]; b < band_edges[i + 1]; b++) {
+			if (bins[b] > peak) peak = bins[b];
+		}
+
+		levels[i] = peak;
+	}
+}
@@ -0,0 +1,33 @@
+#ifndef BANDS_H
+#define BANDS_H
+
+/**
+ * Grouping of FFT bins into logarithmically spaced frequency bands.
+ *
+ * The band edges depend on the sample rate and FFT length,
+ * call bands_configure() when any of them changes.
+ */
+
+#include <stdint.h>
+
+#define BAND_COUNT 16
+
+/** Lowest and highest band edge (Hz); the top is limited by the Nyquist frequency */
+#define BAND_FREQ_MIN 60.0f
+#define BAND_FREQ_MAX 8000.0f
+
+/**
+ * @brief Calculate band edges
+ * @param sample_rate : sample rate (Hz)
+ * @param fft_len : FFT length; bins up to fft_len/2 are used
+ */
+void bands_configure(float sample_rate, uint32_t fft_len);
+
+/**
+ * @brief Reduce a magnitude spectrum to band levels (peak of the bins in each band)
+ * @param bins : magnitudes (or power, the peak is the same bin), at least fft_len/2 long
+ * @param levels : output, BAND_COUNT long
+ */
+void bands_compute(const float *bins, float *levels);
+
+#endif // BANDS_H
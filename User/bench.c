@@ -0,0 +1,629 @@
+#include <inttypes.h>
+#include <string.h>
+#include <stdio.h>
+#include "bench.h"
+#include "debug.h"
+#include "timebase.h"
+#include "debounce.h"
+#include "decimator.h"
+#include "magnitude.h"
+#include "fft_config.h"
+#include "dsp.h"
+#include "render.h"
+
+/** Most dummy 1 ms tasks added for timebase_ms_cb(), the slots of timebase_init(5, 5) left by the debouncer */
+#define BENCH_MAX_TASKS 4
+
+/** Output samples per decimate() call */
+#define BENCH_DECIM_OUT 32
+
+/** Bins per magnitude() call */
+#define BENCH_MAG_BINS (FFT_MAX_LEN / 2)
+
+/** Bars in a full frame (one per column) */
+#define BENCH_FRAME_BARS 32
+
+/** Frame length of the render cases: the default FFT size, the tuner always takes the longest */
+#define BENCH_RENDER_LEN 256
+#define BENCH_TUNER_LEN FFT_MAX_LEN
+
+/** Sample rate the render cases are set up for (Hz) */
+#define BENCH_RENDER_RATE 20000
+
+/** SysTick reload while it times the cases, the 24-bit maximum */
+#define BENCH_SYSTICK_MAX 0xFFFFFF
+
+/**
+ * Status lines. In the host build they go to stderr, stdout holds only the
+ * JSON lines; on the chip everything shares the UART.
+ */
+#ifdef BENCH_HOST
+#define bench_info(fmt, ...) fprintf(stderr, DEBUG_TAG_INFO fmt "\n", ##__VA_ARGS__)
+#define bench_error(fmt, ...) fprintf(stderr, DEBUG_TAG_ERROR fmt "\n", ##__VA_ARGS__)
+#else
+#define bench_info info
+#define bench_error error
+#endif
+
+typedef struct {
+	const char *name;
+	uint32_t n; //!< size parameter, passed to the callbacks
+	uint32_t iterations;
+	void (*setup)(uint32_t n); //!< prepares the input, not timed; can be NULL
+	void (*run)(uint32_t n); //!< the timed call
+	bool target_only; //!< needs the peripherals, skipped in the host and QEMU builds
+} bench_case_t;
+
+static DotMatrix_Cfg *bench_disp;
+static uint32_t *bench_buf;
+
+/**
+ * The display with a null SPI: registers in RAM, always ready (TXE set,
+ * BSY clear), the frames go nowhere. Times the CPU side of dmtx_show().
+ */
+static DotMatrix_Cfg bench_null_disp;
+static SPI_TypeDef bench_null_spi;
+static GPIO_TypeDef bench_null_gpio;
+
+/** Port of the debouncer case's pins, in RAM; IDR is 0, the inverted pins are all held */
+static GPIO_TypeDef bench_debo_gpio;
+
+/** Varies the arguments between iterations */
+static uint32_t bench_step;
+
+/** Cycles of an empty case, subtracted from the results */
+static uint32_t bench_overhead;
+
+/** The DWT cycle counter doesn't run, SysTick counts the cycles */
+static bool bench_systick;
+
+
+// region Inputs
+
+/** Fill the buffer with noise sample words, both channels */
+static void fill_samples(uint32_t n)
+{
+	static uint32_t seed = 1;
+
+	for (uint32_t i = 0; i < n; i++) {
+		seed = seed * 1664525 + 1013904223;
+		bench_buf[i] = seed & 0xFFF0FFF0; // 16-bit samples, like the decimator output
+	}
+}
+
+/** Fill the buffer with raw ADC words (12-bit) for the decimator */
+static void fill_adc(uint32_t n)
+{
+	UNUSED(n);
+
+	fill_samples(BENCH_DECIM_OUT * DECIM_MAX_RATIO);
+	for (uint32_t i = 0; i < BENCH_DECIM_OUT * DECIM_MAX_RATIO; i++) {
+		bench_buf[i] = (bench_buf[i] >> 4) & 0x0FFF0FFF;
+	}
+}
+
+/** Fill the buffer with complex values for magnitude(), out goes after them */
+static void fill_complex(uint32_t n)
+{
+	float *cplx = (float *) bench_buf;
+
+	fill_samples(n * 2);
+	for (uint32_t i = 0; i < n * 2; i++) {
+		cplx[i] = (float) (int16_t) bench_buf[i];
+	}
+}
+
+// endregion
+
+// region Old cell layout
+
+// The display code before the row-word framebuffer: pixels live directly in
+// the digit-major transmit buffer, one byte per driver and digit. Kept here
+// to compare the two layouts on the chip.
+
+static uint8_t *cell_ptr(DotMatrix_Cfg *disp, int32_t x, int32_t y, uint8_t *xd)
+{
+	if (x < 0 || y < 0) return NULL;
+	if ((uint32_t)x >= disp->cols*8 || (uint32_t)y >= disp->rows*8) return NULL;
+
+	uint32_t cell_x = (uint32_t)x >> 3;
+	*xd = x & 7;
+
+	uint32_t digit = y & 7;
+	cell_x += ((uint32_t)y >> 3) * disp->cols;
+
+	return &disp->screen[(digit * disp->drv.chain_len) + cell_x];
+}
+
+static void cell_set(DotMatrix_Cfg *disp, int32_t x, int32_t y, bool bit)
+{
+	uint8_t xd;
+	uint8_t *cell = cell_ptr(disp, x, y, &xd);
+	if (cell == NULL) return;
+
+	if (bit) {
+		*cell |= 1 << xd;
+	} else {
+		*cell &= ~(1 << xd);
+	}
+}
+
+static void cell_set_block(DotMatrix_Cfg *disp, int32_t startX, int32_t startY, const uint32_t *data_rows, uint32_t width, uint16_t height)
+{
+	for (uint32_t y = 0; y < height; y++) {
+		uint32_t row = data_rows[y];
+
+		for (uint32_t x = 0; x < width; x++) {
+			cell_set(disp, startX + (int)x, startY + (int)y, (row >> (width - x - 1)) & 1);
+		}
+	}
+}
+
+static void cell_clear(DotMatrix_Cfg *disp)
+{
+	memset(disp->screen, 0, disp->drv.chain_len * 8);
+}
+
+// endregion
+
+// region Cases
+
+static void run_nop(uint32_t n)
+{
+	UNUSED(n);
+	__NOP();
+}
+
+static void run_dmtx_clear(uint32_t n)
+{
+	UNUSED(n);
+	dmtx_clear(bench_disp);
+}
+
+static void run_dmtx_set(uint32_t n)
+{
+	UNUSED(n);
+	bench_step++;
+	dmtx_set(bench_disp, bench_step & 31, (bench_step >> 5) & 15, bench_step & 1);
+}
+
+static void run_dmtx_set_block(uint32_t n)
+{
+	static const uint32_t block[8] = {0x3C, 0x42, 0x81, 0xA5, 0x81, 0x99, 0x42, 0x3C};
+
+	bench_step++;
+	dmtx_set_block(bench_disp, bench_step % 28, bench_step % 12, block, n, 8);
+}
+
+/** Height of bar x in the test frame, changes every frame */
+static inline int32_t bar_height(uint32_t x)
+{
+	return (int32_t) ((x * 7 + bench_step) % 17);
+}
+
+static void run_cell_clear(uint32_t n)
+{
+	UNUSED(n);
+	cell_clear(bench_disp);
+}
+
+static void run_cell_set(uint32_t n)
+{
+	UNUSED(n);
+	bench_step++;
+	cell_set(bench_disp, bench_step & 31, (bench_step >> 5) & 15, bench_step & 1);
+}
+
+static void run_cell_set_block(uint32_t n)
+{
+	static const uint32_t block[8] = {0x3C, 0x42, 0x81, 0xA5, 0x81, 0x99, 0x42, 0x3C};
+
+	bench_step++;
+	cell_set_block(bench_disp, bench_step % 28, bench_step % 12, block, n, 8);
+}
+
+/** A bar graph frame the way the renderers draw it, ready to send (packed) */
+static void run_frame_rows(uint32_t n)
+{
+	bench_step++;
+	dmtx_clear(bench_disp);
+	for (uint32_t x = 0; x < n; x++) {
+		for (int32_t y = 0; y < bar_height(x); y++) {
+			dmtx_set(bench_disp, x, y, 1);
+		}
+	}
+	dmtx_pack(bench_disp);
+}
+
+/** The same frame in the old cell layout, no packing needed */
+static void run_frame_cells(uint32_t n)
+{
+	bench_step++;
+	cell_clear(bench_disp);
+	for (uint32_t x = 0; x < n; x++) {
+		for (int32_t y = 0; y < bar_height(x); y++) {
+			cell_set(bench_disp, x, y, 1);
+		}
+	}
+}
+
+static void run_dmtx_pack(uint32_t n)
+{
+	UNUSED(n);
+	dmtx_pack(bench_disp);
+}
+
+static void run_dmtx_show(uint32_t n)
+{
+	UNUSED(n);
+	dmtx_show(bench_disp);
+}
+
+static void run_dmtx_show_null(uint32_t n)
+{
+	UNUSED(n);
+	dmtx_show(&bench_null_disp);
+}
+
+static void run_timebase_ms_cb(uint32_t n)
+{
+	UNUSED(n);
+	timebase_ms_cb();
+}
+
+static void run_debo_periodic_task(uint32_t n)
+{
+	UNUSED(n);
+	debo_periodic_task(NULL);
+}
+
+/** The FFT configuration of a length */
+static const fft_config_t *bench_fft_config(uint32_t n)
+{
+	for (uint32_t i = 0; i < FFT_CONFIG_COUNT; i++) {
+		const fft_config_t *cfg = fft_config_get(i);
+		if (cfg->fft_len == n) return cfg;
+	}
+
+	return fft_config_get(FFT_CONFIG_DEFAULT);
+}
+
+static void run_samples_to_float(uint32_t n)
+{
+	dsp_samples_to_float(bench_buf, n);
+}
+
+static void run_decimate(uint32_t n)
+{
+	decimate(bench_buf, bench_buf + FFT_MAX_LEN, BENCH_DECIM_OUT, n);
+}
+
+static void run_magnitude_exact(uint32_t n)
+{
+	magnitude((float *) bench_buf, (float *) bench_buf + n * 2, n, MAG_EXACT);
+}
+
+static void run_magnitude_squared(uint32_t n)
+{
+	magnitude((float *) bench_buf, (float *) bench_buf + n * 2, n, MAG_SQUARED);
+}
+
+static void run_magnitude_ambm(uint32_t n)
+{
+	magnitude((float *) bench_buf, (float *) bench_buf + n * 2, n, MAG_AMBM);
+}
+
+static void run_dsp_spectrum(uint32_t n)
+{
+	dsp_spectrum(bench_buf, bench_fft_config(n), 1.0f, MAG_SQUARED);
+}
+
+/** Start of a rendered frame: clear it, no overlay */
+static void render_start(void)
+{
+	dmtx_clear(&bench_null_disp);
+}
+
+/** End of a rendered frame: show it on the null SPI */
+static void render_finish(void)
+{
+	dmtx_show(&bench_null_disp);
+}
+
+/** Render a frame of noise, with the default settings; the frames follow each other by the sample clock */
+static void render(render_mode_t mode, uint32_t n)
+{
+	bench_step++;
+
+	const render_args_t args = {
+		.fft = bench_fft_config(n),
+		.sample_rate = BENCH_RENDER_RATE,
+		.time = bench_step * n * 1000 / BENCH_RENDER_RATE,
+		.y_scale = 5,
+		.db_scale = false,
+	};
+	render_frame(mode, &args);
+}
+
+static void run_render_spectrum(uint32_t n)
+{
+	render(RENDER_SPECTRUM, n);
+}
+
+static void run_render_spindle(uint32_t n)
+{
+	render(RENDER_SPINDLE, n);
+}
+
+static void run_render_waveform(uint32_t n)
+{
+	render(RENDER_WAVEFORM, n);
+}
+
+static void run_render_waterfall(uint32_t n)
+{
+	render(RENDER_WATERFALL, n);
+}
+
+static void run_render_vu(uint32_t n)
+{
+	render(RENDER_VU, n);
+}
+
+static void run_render_stereo(uint32_t n)
+{
+	render(RENDER_STEREO, n);
+}
+
+static void run_render_phase(uint32_t n)
+{
+	render(RENDER_PHASE, n);
+}
+
+static void run_render_beat(uint32_t n)
+{
+	render(RENDER_BEAT, n);
+}
+
+static void run_render_tuner(uint32_t n)
+{
+	render(RENDER_TUNER, n);
+}
+
+/** Dummy task for the timebase benchmark */
+static void nop_task(void *unused)
+{
+	UNUSED(unused);
+}
+
+static const bench_case_t bench_cases[] = {
+	{"dmtx_clear", 0, 100, NULL, run_dmtx_clear},
+	{"dmtx_set", 0, 512, NULL, run_dmtx_set},
+	{"dmtx_set_block", 8, 100, NULL, run_dmtx_set_block},
+	{"dmtx_pack", 0, 100, NULL, run_dmtx_pack},
+	{"dmtx_show", 0, 20, NULL, run_dmtx_show, true},
+	{"dmtx_show_null", 0, 20, NULL, run_dmtx_show_null},
+	{"cell_clear", 0, 100, NULL, run_cell_clear},
+	{"cell_set", 0, 512, NULL, run_cell_set},
+	{"cell_set_block", 8, 100, NULL, run_cell_set_block},
+	{"frame_rows", BENCH_FRAME_BARS, 50, NULL, run_frame_rows},
+	{"frame_cells", BENCH_FRAME_BARS, 50, NULL, run_frame_cells},
+	{"decimate", 1, 50, fill_adc, run_decimate},
+	{"decimate", 4, 50, fill_adc, run_decimate},
+	{"decimate", 16, 50, fill_adc, run_decimate},
+	{"samples_to_float", 256, 20, fill_samples, run_samples_to_float},
+	{"samples_to_float", 1024, 10, fill_samples, run_samples_to_float},
+	{"magnitude_exact", BENCH_MAG_BINS, 10, fill_complex, run_magnitude_exact},
+	{"magnitude_squared", BENCH_MAG_BINS, 10, fill_complex, run_magnitude_squared},
+	{"magnitude_ambm", BENCH_MAG_BINS, 10, fill_complex, run_magnitude_ambm},
+	{"dsp_spectrum", 64, 20, fill_samples, run_dsp_spectrum},
+	{"dsp_spectrum", 128, 20, fill_samples, run_dsp_spectrum},
+	{"dsp_spectrum", 256, 10, fill_samples, run_dsp_spectrum},
+	{"dsp_spectrum", 512, 10, fill_samples, run_dsp_spectrum},
+	{"dsp_spectrum", 1024, 5, fill_samples, run_dsp_spectrum},
+	{"render_spectrum", BENCH_RENDER_LEN, 10, fill_samples, run_render_spectrum},
+	{"render_spindle", BENCH_RENDER_LEN, 10, fill_samples, run_render_spindle},
+	{"render_waveform", BENCH_RENDER_LEN, 10, fill_samples, run_render_waveform},
+	{"render_waterfall", BENCH_RENDER_LEN, 10, fill_samples, run_render_waterfall},
+	{"render_vu", BENCH_RENDER_LEN, 10, fill_samples, run_render_vu},
+	{"render_stereo", BENCH_RENDER_LEN, 10, fill_samples, run_render_stereo},
+	{"render_phase", BENCH_RENDER_LEN, 10, fill_samples, run_render_phase},
+	{"render_beat", BENCH_RENDER_LEN, 10, fill_samples, run_render_beat},
+	{"render_tuner", BENCH_TUNER_LEN, 5, fill_samples, run_render_tuner},
+};
+
+#define BENCH_CASE_COUNT (sizeof(bench_cases) / sizeof(bench_cases[0]))
+
+/** timebase_ms_cb() with this many dummy tasks on top of the registered ones, see bench_timebase() */
+static const uint32_t bench_task_counts[] = {0, 1, 2, BENCH_MAX_TASKS};
+
+/** debo_periodic_task() with this many held pins, see bench_debounce() */
+static const uint32_t bench_pin_counts[] = {1, 4, BENCH_DEBO_PINS};
+
+// endregion
+
+/** The cycle counter; in the host build ns of the host clock (SystemCoreClock is 1 GHz there) */
+static inline uint32_t bench_cycles(void)
+{
+#ifdef BENCH_HOST
+	return bench_host_cycles();
+#else
+	if (bench_systick) return BENCH_SYSTICK_MAX - SysTick->VAL; // counts down
+	return DWT->CYCCNT;
+#endif
+}
+
+/** Cycles since `start`; SysTick wraps at 24 bits (0.23 s at 72 MHz) */
+static inline uint32_t bench_elapsed(uint32_t start)
+{
+	const uint32_t cycles = bench_cycles() - start;
+	return bench_systick ? (cycles & BENCH_SYSTICK_MAX) : cycles;
+}
+
+/**
+ * @brief Time a case
+ * @param c : the case
+ * @param print : print the result
+ * @return min cycles
+ */
+static uint32_t bench_case(const bench_case_t *c, bool print)
+{
+	uint32_t min = UINT32_MAX;
+	uint32_t total = 0;
+
+	for (uint32_t i = 0; i < c->iterations; i++) {
+		if (c->setup) c->setup(c->n);
+
+		__disable_irq();
+		const uint32_t start = bench_cycles();
+		c->run(c->n);
+		uint32_t cycles = bench_elapsed(start);
+		__enable_irq();
+
+		cycles = (cycles > bench_overhead) ? cycles - bench_overhead : 0;
+		if (cycles < min) min = cycles;
+		total += cycles;
+	}
+
+	if (print) {
+		const uint32_t mean = total / c->iterations;
+		const uint32_t ns = (uint32_t) ((uint64_t) mean * 1000000000 / SystemCoreClock);
+
+		dbg_printf("{\"bench\":\"%s\",\"n\":%"PRIu32",\"iters\":%"PRIu32
+				   ",\"cycles_min\":%"PRIu32",\"cycles_mean\":%"PRIu32",\"ns_mean\":%"PRIu32"}" DEBUG_EOL,
+				   c->name, c->n, c->iterations, min, mean, ns);
+	}
+
+	return min;
+}
+
+/** Time timebase_ms_cb() with more and more dummy tasks, n is their number; removes them after */
+static void bench_timebase(void)
+{
+	task_pid_t pids[BENCH_MAX_TASKS];
+	uint32_t added = 0;
+
+	for (uint32_t i = 0; i < sizeof(bench_task_counts) / sizeof(bench_task_counts[0]); i++) {
+		while (added < bench_task_counts[i]) {
+			pids[added] = add_periodic_task(nop_task, NULL, 1, false);
+			if (pids[added] == PID_NONE) {
+				bench_error("No free timebase slot for the task %"PRIu32, added + 1);
+				goto done;
+			}
+			added++;
+		}
+
+		const bench_case_t c = {"timebase_ms_cb", added, 100, NULL, run_timebase_ms_cb};
+		bench_case(&c, true);
+	}
+
+done:
+	while (added > 0) remove_periodic_task(pids[--added]);
+}
+
+/**
+ * Time debo_periodic_task() with more and more pins of the bench port, n
+ * is their number. They are all held with auto-repeat on every call, the
+ * most work a pin makes; removed after.
+ */
+static void bench_debounce(void)
+{
+	debo_id_t ids[BENCH_DEBO_PINS];
+	uint32_t added = 0;
+
+	debo_init_t debo;
+	memset(&debo, 0, sizeof(debo));
+	debo.GPIOx = &bench_debo_gpio;
+	debo.invert = true;
+	debo.repeat_delay = 1;
+	debo.repeat_interval = 1;
+
+	for (uint32_t i = 0; i < sizeof(bench_pin_counts) / sizeof(bench_pin_counts[0]); i++) {
+		while (added < bench_pin_counts[i]) {
+			debo.pin = (uint16_t) (1 << added);
+			ids[added] = debo_register_pin(&debo);
+			if (ids[added] == DEBO_PIN_NONE) {
+				bench_error("No free debouncer slot for the pin %"PRIu32, added + 1);
+				goto done;
+			}
+			added++;
+		}
+
+		const bench_case_t c = {"debo_periodic_task", added, 100, NULL, run_debo_periodic_task};
+		bench_case(&c, true);
+	}
+
+done:
+	while (added > 0) debo_remove_pin(ids[--added]);
+}
+
+void bench_run(DotMatrix_Cfg *disp, uint32_t *buf)
+{
+	bench_disp = disp;
+	bench_buf = buf;
+
+	bench_null_disp = *disp;
+	bench_null_spi.SR = SPI_SR_TXE;
+	bench_null_disp.drv.SPIx = &bench_null_spi;
+	bench_null_disp.drv.CS_GPIOx = &bench_null_gpio;
+
+	// the renderers draw on the null display, the visualiser doesn't run
+	render_init_t render_cfg;
+	render_cfg.disp = &bench_null_disp;
+	render_cfg.samples = buf;
+	render_cfg.start = render_start;
+	render_cfg.finish = render_finish;
+	render_init(&render_cfg);
+
+#ifndef BENCH_HOST
+	// start the cycle counter
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+	// not all emulators implement the DWT (QEMU doesn't), SysTick does;
+	// it runs free at the core clock, the ms tick stops until the end
+	const uint32_t systick_ctrl = SysTick->CTRL;
+	const uint32_t systick_load = SysTick->LOAD;
+	bench_systick = (DWT->CYCCNT == 0);
+	if (bench_systick) {
+		SysTick->LOAD = BENCH_SYSTICK_MAX;
+		SysTick->VAL = 0;
+		SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_ENABLE_Msk;
+	}
+#endif
+
+	const bench_case_t nop = {"nop", 0, 100, NULL, run_nop};
+	bench_overhead = 0;
+	bench_overhead = bench_case(&nop, false);
+
+	const char *clock = bench_systick ? "SysTick" : "cycle counter";
+#ifdef BENCH_HOST
+	clock = "host clock";
+#endif
+	bench_info("Benchmark, %"PRIu32" MHz, %s, overhead %"PRIu32" cycles", SystemCoreClock / 1000000, clock, bench_overhead);
+
+	for (uint32_t i = 0; i < BENCH_CASE_COUNT; i++) {
+#if defined(BENCH_HOST) || defined(BENCH_QEMU)
+		if (bench_cases[i].target_only) continue;
+#endif
+		bench_case(&bench_cases[i], true);
+	}
+
+	bench_timebase();
+	bench_debounce();
+
+	// leave the display blank
+	dmtx_clear(disp);
+	dmtx_show(disp);
+
+#ifndef BENCH_HOST
+	if (bench_systick) {
+		SysTick->LOAD = systick_load;
+		SysTick->VAL = 0;
+		SysTick->CTRL = systick_ctrl;
+	}
+#endif
+
+	bench_info("Benchmark done");
+}
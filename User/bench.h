@@ -0,0 +1,68 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+/**
+ * On-target micro-benchmarks of the User/ modules.
+ *
+ * Built with -DBENCHMARK=ON (CMake option), the firmware runs the
+ * benchmarks after init instead of the visualiser. Each call is timed with
+ * the DWT cycle counter, interrupts disabled, and the cost of an empty call
+ * is subtracted. Where the cycle counter doesn't run (QEMU), SysTick counts
+ * the cycles instead, free running for the duration; it stops the ms tick.
+ * Results are printed to the debug UART, one JSON object per line:
+ *
+ *   {"bench":"dsp_spectrum","n":256,"iters":16,"cycles_min":..,"cycles_mean":..,"ns_mean":..}
+ *
+ * "n" is the size parameter of the case (samples, bins, decimation ratio,
+ * timer tasks or debouncer pins), 0 if it has none. Lines start with '{',
+ * so they are easy to grep out of the log.
+ *
+ * timebase_ms_cb() runs with 0..4 dummy 1 ms tasks added to the registered
+ * ones (the debouncer's), debo_periodic_task() with 1, 4 and 8 pins on a
+ * port in RAM, all held and repeating. bench_run() registers and removes
+ * them; the debouncer needs BENCH_DEBO_PINS free slots. On the chip the
+ * five buttons stay registered too (released), the host and QEMU builds
+ * have none.
+ *
+ * dmtx_show() is timed with the real SPI, so it includes the transfer,
+ * and as dmtx_show_null with registers in RAM that are always ready: the
+ * CPU side only (packing and register writes).
+ *
+ * The render_<mode> cases run render_frame() (render.h) on a frame of
+ * noise, from the captured samples to the frame shown on the null SPI:
+ * the FFT, the band and meter processing, the drawing, and the packing.
+ * "n" is the frame length, the default 256, for the tuner the longest.
+ *
+ * The cell_* and frame_cells cases run the display code of the old cell
+ * layout (pixels stored in the transmit buffer) next to the row-word
+ * framebuffer: frame_rows draws a bar graph and packs it, frame_cells
+ * draws the same frame straight into the transmit buffer.
+ */
+
+#include <stdint.h>
+#include "dotmatrix.h"
+
+/** Debouncer slots bench_run() needs free for its pins */
+#define BENCH_DEBO_PINS 8
+
+/**
+ * Host build (-DBENCH_HOST, test/bench_host.c): the cases that don't need
+ * the peripherals, timed by the host clock. The harness provides the time
+ * in ns, and SystemCoreClock = 1 GHz, so "cycles" are ns there. The status
+ * lines go to stderr, stdout is only JSON.
+ *
+ * QEMU build (-DBENCH_QEMU, qemu/bench_qemu.c): the same cases on an
+ * emulated Cortex-M3, timed by SysTick.
+ */
+#ifdef BENCH_HOST
+uint32_t bench_host_cycles(void);
+#endif
+
+/**
+ * @brief Run all benchmarks & print the results
+ * @param disp : initialised display
+ * @param buf : scratch buffer, FFT_MAX_LEN * 2 words
+ */
+void bench_run(DotMatrix_Cfg *disp, uint32_t *buf);
+
+#endif // BENCH_H
@@ -0,0 +1,161 @@
+#include "capture.h"
+#include "decimator.h"
+#include "adc.h"
+#include "tim.h"
+
+/** TIM3 period set by MX_TIM3_Init() (ticks) */
+#define MX_PERIOD 3601
+
+/** Raw words per DMA half-buffer, must be a multiple of DECIM_MAX_RATIO */
+#define CHUNK_LEN 64
+
+/** Circular DMA buffer, two chunks */
+static uint32_t raw_buf[CHUNK_LEN * 2];
+
+/** Capture in progress flag */
+static volatile bool capture_pending = false;
+
+// Requested mode, applied at the next capture start
+static volatile uint32_t req_period = MX_PERIOD;
+static volatile uint32_t req_ratio = 1;
+
+// Mode of the last started capture
+static uint32_t timer_period = MX_PERIOD;
+static uint32_t ratio = 1;
+
+// Frame being captured
+static uint32_t *out_buf;
+static uint32_t out_count;
+static uint32_t out_pos;
+
+/** Chunks to drop after a rate change, they may mix the two rates */
+static uint32_t skip_chunks = 0;
+
+/** Frame clock: ms since capture_init(), and the CPU cycles of the next ms */
+static volatile ms_time_t clock_ms = 0;
+static uint32_t clock_cycles = 0;
+
+/** The DWT cycle counter runs, and its value at the last chunk */
+static bool have_cyccnt = false;
+static uint32_t last_cyccnt;
+
+#define CYCLES_PER_MS (F_CPU / 1000)
+
+
+void capture_init(void)
+{
+	// the frame clock counts CPU cycles, they go on during a long render
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+	last_cyccnt = DWT->CYCCNT;
+	__NOP();
+	__NOP();
+	have_cyccnt = DWT->CYCCNT != last_cyccnt; // not all emulators implement the DWT
+
+	// ADC2 is enabled along with ADC1, the result pairs land in ADC1->DR
+	HAL_ADCEx_MultiModeStart_DMA(&hadc1, raw_buf, CHUNK_LEN * 2);
+	HAL_TIM_Base_Start(&htim3);
+}
+
+
+void capture_start(uint32_t *buf, uint32_t count)
+{
+	if (capture_pending) return;
+
+	// the timer keeps running, switch it to the new rate
+	if (timer_period != req_period) {
+		timer_period = req_period;
+		__HAL_TIM_SET_AUTORELOAD(&htim3, timer_period - 1);
+		__HAL_TIM_SET_COUNTER(&htim3, 0);
+		skip_chunks = 1;
+	}
+
+	ratio = req_ratio;
+	out_buf = buf;
+	out_count = count;
+	out_pos = 0;
+
+	__DMB(); // the frame must be set up before the DMA interrupt sees the flag
+	capture_pending = true;
+}
+
+
+void capture_set_rate(uint32_t rate, uint32_t oversample)
+{
+	while (oversample > 1 && rate * oversample > CAPTURE_ADC_MAX_RATE) {
+		oversample /= 2;
+	}
+
+	const uint32_t adc_rate = rate * oversample;
+
+	req_period = (F_CPU + adc_rate / 2) / adc_rate;
+	req_ratio = oversample;
+}
+
+
+ms_time_t capture_time(void)
+{
+	return clock_ms;
+}
+
+
+float capture_sample_rate(void)
+{
+	return F_CPU / (float) (timer_period * ratio);
+}
+
+
+bool capture_busy(void)
+{
+	return capture_pending;
+}
+
+
+/** Decimate a filled half of the DMA buffer into the frame */
+static void chunk_done(const uint32_t *chunk)
+{
+	// without the cycle counter, each conversion takes one timer period;
+	// that misses the chunks dropped while a render holds off this interrupt
+	uint32_t cycles = CHUNK_LEN * timer_period;
+	if (have_cyccnt) {
+		const uint32_t now = DWT->CYCCNT;
+		cycles = now - last_cyccnt;
+		last_cyccnt = now;
+	}
+
+	clock_cycles += cycles;
+	clock_ms += clock_cycles / CYCLES_PER_MS;
+	clock_cycles %= CYCLES_PER_MS;
+
+	if (!capture_pending) return;
+
+	if (skip_chunks > 0) {
+		skip_chunks--;
+		return;
+	}
+
+	uint32_t n = CHUNK_LEN / ratio;
+	if (n > out_count - out_pos) n = out_count - out_pos;
+
+	decimate(chunk, out_buf + out_pos, n, ratio);
+	out_pos += n;
+
+	if (out_pos == out_count) {
+		capture_complete_cb();
+		capture_pending = false;
+	}
+}
+
+
+/** Called by HAL when the first half of the DMA buffer is filled */
+void HAL_ADC_ConvHalfCpltCallback(ADC_HandleTypeDef *hadc)
+{
+	chunk_done(raw_buf);
+}
+
+
+/** Called by HAL when the second half of the DMA buffer is filled */
+void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc)
+{
+	chunk_done(raw_buf + CHUNK_LEN);
+}
@@ -0,0 +1,73 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+/**
+ * Stereo audio capture, ADC1 + ADC2 in dual regular simultaneous mode.
+ *
+ * Both ADCs convert at the same TIM3 trigger. Each sample pair is one
+ * 32-bit DMA transfer of ADC1->DR: left (ADC1, PB1) in the low halfword,
+ * right (ADC2, PB0) in the high halfword.
+ *
+ * TIM3 triggers the conversions; the rate is changed between captures.
+ * The DMA runs continuously into a small circular buffer. Its halves are
+ * decimated (see decimator.h) into the frame buffer of a started capture,
+ * so the ADCs can run oversampled at a multiple of the output rate.
+ * Output samples are 16-bit regardless of the oversampling ratio.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "timebase.h"
+
+/** Extract the left / right channel from a captured word */
+#define SAMPLE_L(word) ((word) & 0xFFFF)
+#define SAMPLE_R(word) ((word) >> 16)
+
+/** Highest ADC conversion rate (Hz); one conversion is 20 cycles at 12 MHz */
+#define CAPTURE_ADC_MAX_RATE 500000
+
+/** Start streaming the ADC data, called once at startup */
+void capture_init(void);
+
+/**
+ * @brief Start a capture, if none is in progress
+ * @param buf : buffer for the sample words
+ * @param count : number of sample pairs
+ */
+void capture_start(uint32_t *buf, uint32_t count);
+
+/**
+ * @brief Select the sample rate & oversampling, applied at the next capture start
+ *
+ * The ratio is reduced if the ADC can't convert that fast. The TIM3 period
+ * is a whole number of CPU cycles, so the actual rate can differ slightly,
+ * see capture_sample_rate().
+ *
+ * @param rate : output sample rate (Hz)
+ * @param oversample : ADC conversions per output sample (1, 2, 4, 8 or 16)
+ */
+void capture_set_rate(uint32_t rate, uint32_t oversample);
+
+/** Get the sample rate of the last started capture (Hz) */
+float capture_sample_rate(void);
+
+/**
+ * @brief Get the frame clock (ms)
+ *
+ * Time since capture_init(), updated with each DMA half-buffer (CHUNK_LEN
+ * conversions) from the DWT cycle counter, so it keeps time even while an
+ * interrupt at the SysTick priority holds off ms_now(), and across the
+ * half-buffers lost while a long render holds off the DMA interrupt.
+ * Without the cycle counter (some emulators) the conversions are counted
+ * instead, which misses those. In capture_complete_cb() it is the time of
+ * the frame's last sample.
+ */
+ms_time_t capture_time(void);
+
+/** Check if a capture is in progress */
+bool capture_busy(void);
+
+/** Called when the capture is complete, in the DMA interrupt. Implemented by the application. */
+void capture_complete_cb(void);
+
+#endif // CAPTURE_H
@@ -1,36 +1,80 @@
 #include <stdbool.h>
 #include "debounce.h"
 #include "timebase.h"
-#include "malloc_safe.h"
+#include "arena.h"
 
 // ms debounce time
 
 #define DEF_DEBO_TIME 20
 
+/**
+ * Number of vertical counter bit planes.
+ * Limits the debounce time to DEBO_TIME_MAX ms.
+ */
+#define DEBO_CNT_BITS 8
+#define DEBO_TIME_MAX ((1 << DEBO_CNT_BITS) - 1)
+
+/** Event queue length, must be a power of 2 */
+#define DEBO_QUEUE_LEN 16
+
+/**
+ * All pins of one GPIO port, debounced together.
+ *
+ * The counters are "vertical" - bit plane N holds bit N of the counter
+ * of every pin on the port, so the whole port is updated with a few
+ * bitwise operations per tick.
+ */
 typedef struct {
-	GPIO_TypeDef *GPIOx;         ///< GPIO base
+	GPIO_TypeDef *GPIOx;         ///< GPIO base, NULL = unused
+	uint16_t mask;               ///< pins in use
+	uint16_t invert;             ///< pins with inverted value
+	uint16_t state;              ///< debounced state (after inversion)
+	uint16_t cnt[DEBO_CNT_BITS]; ///< counters of samples differing from state (ms)
+	uint16_t thr[DEBO_CNT_BITS]; ///< debouncing time of each pin (ms)
+} debo_port_t;
+
+
+typedef struct {
+	debo_port_t *port;           ///< port group the pin belongs to
 	uint16_t pin;                ///< bit mask
-	bool state;                  ///< current state
-	bool invert;                 ///< invert pin
 	debo_id_t id;                ///< pin ID
 	uint32_t cb_payload;         ///< payload passed to the callbac
-	ms_time_t debo_time;         ///< debouncing time (ms)
-	ms_time_t counter_0;         ///< counter for falling edge (ms)
-	ms_time_t counter_1;         ///< counter for rising edge (ms)
-	void (*callback)(uint32_t, bool);
+	ms_time_t long_time;         ///< hold time for long press (ms), 0 = off
+	ms_time_t repeat_delay;      ///< hold time for the first repeat (ms), 0 = off
+	ms_time_t repeat_interval;   ///< interval of repeats (ms)
+	ms_time_t held;              ///< time the pin is held active (ms)
+	ms_time_t next_repeat;       ///< hold time of the next repeat (ms)
+	void (*callback)(uint32_t, debo_event_t);
 } debo_slot_t;
 
 
-/** Number of allocated slots */
+/** Queued event, dispatched in the main loop */
+typedef struct {
+	void (*callback)(uint32_t, debo_event_t);
+	uint32_t cb_payload;
+	debo_event_t event;
+} debo_queued_t;
+
+
+/** Number of allocated slots (and port groups) */
 static size_t debo_slot_count = 0;
 
 /** Slots array */
 static debo_slot_t *debo_slots;
 
+/** Port groups array, one entry per GPIO port in use */
+static debo_port_t *debo_ports;
+
 /** Next free pin ID for make_id() */
 static debo_id_t next_pin_id = 1;
 
-void debo_periodic_task(void *unused);
+/**
+ * Event queue - written only by the periodic task (head),
+ * read only by debo_process_events() (tail), so no locking is needed.
+ */
+static debo_queued_t debo_queue[DEBO_QUEUE_LEN];
+static volatile uint32_t debo_queue_head = 0;
+static volatile uint32_t debo_queue_tail = 0;
 
 
 /**
@@ -53,13 +97,39 @@ static debo_id_t make_id(void)
 /** Init the debouncer */
 void debounce_init(size_t slot_count)
 {
-	debo_slots = calloc_s(slot_count, sizeof(debo_slot_t));
+	debo_slots = arena_calloc(slot_count, sizeof(debo_slot_t));
+	debo_ports = arena_calloc(slot_count, sizeof(debo_port_t));
 	debo_slot_count = slot_count;
 
 	add_periodic_task(debo_periodic_task, NULL, 1, false);
 }
 
 
+/**
+ * @brief Find the group for a GPIO port, or claim a free one.
+ * @param GPIOx : GPIO base
+ * @return the group, NULL if none is free
+ */
+static debo_port_t *claim_port(GPIO_TypeDef *GPIOx)
+{
+	debo_port_t *empty = NULL;
+
+	for (size_t i = 0; i < debo_slot_count; i++) {
+		debo_port_t *port = &debo_ports[i];
+
+		if (port->GPIOx == GPIOx) return port;
+		if (port->GPIOx == NULL && empty == NULL) empty = port;
+	}
+
+	if (empty != NULL) {
+		empty->GPIOx = GPIOx;
+		empty->mask = 0;
+	}
+
+	return empty;
+}
+
+
 /** Register a pin */
 debo_id_t debo_register_pin(debo_init_t *init)
 {
@@ -68,18 +138,44 @@ debo_id_t debo_register_pin(debo_init_t *init)
 
 		if (slot->id != DEBO_PIN_NONE) continue; // slot is used
 
-		slot->GPIOx = init->GPIOx;
-		slot->pin = init->pin;
+		debo_port_t *port = claim_port(init->GPIOx);
+		if (port == NULL) return DEBO_PIN_NONE;
+
+		uint16_t pin = init->pin;
+
+		slot->port = port;
+		slot->pin = pin;
 		slot->callback = init->callback;
 		slot->cb_payload = init->cb_payload;
-		slot->invert = init->invert;
-		slot->counter_0 = 0;
-		slot->counter_1 = 0;
-		slot->debo_time = (init->debo_time == 0) ? DEF_DEBO_TIME : init->debo_time;
+		slot->long_time = init->long_time;
+		slot->repeat_delay = init->repeat_delay;
+		slot->repeat_interval = (init->repeat_interval == 0) ? init->repeat_delay : init->repeat_interval;
+		slot->held = 0;
+		slot->next_repeat = slot->repeat_delay;
+
+		ms_time_t debo_time = (init->debo_time == 0) ? DEF_DEBO_TIME : init->debo_time;
+		if (debo_time > DEBO_TIME_MAX) debo_time = DEBO_TIME_MAX;
+
+		for (int b = 0; b < DEBO_CNT_BITS; b++) {
+			port->cnt[b] &= ~pin;
+
+			if ((debo_time >> b) & 1) {
+				port->thr[b] |= pin;
+			} else {
+				port->thr[b] &= ~pin;
+			}
+		}
+
+		if (init->invert) {
+			port->invert |= pin;
+		} else {
+			port->invert &= ~pin;
+		}
 
-		bool state = HAL_GPIO_ReadPin(slot->GPIOx, slot->pin);
-		if (slot->invert) state = !state;
-		slot->state = state;
+		uint16_t state = (uint16_t) (port->GPIOx->IDR ^ port->invert);
+		port->state = (port->state & ~pin) | (state & pin);
+
+		port->mask |= pin;
 
 		slot->id = make_id();
 
@@ -90,46 +186,117 @@ debo_id_t debo_register_pin(debo_init_t *init)
 }
 
 
-/** Callback that must be called every 1 ms */
-void debo_periodic_task(void *unused)
+/** Put an event on the queue. Events are dropped if it's full. */
+static void post_event(debo_slot_t *slot, debo_event_t event)
 {
-	UNUSED(unused);
+	if (slot->callback == NULL) return;
+
+	uint32_t head = debo_queue_head;
+	if (head - debo_queue_tail >= DEBO_QUEUE_LEN) return; // full
 
+	debo_queued_t *item = &debo_queue[head & (DEBO_QUEUE_LEN - 1)];
+	item->callback = slot->callback;
+	item->cb_payload = slot->cb_payload;
+	item->event = event;
+
+	__DMB(); // item must be written before it's published
+	debo_queue_head = head + 1;
+}
+
+
+/** Post events for pins of a port that just changed state */
+static void notify_changes(debo_port_t *port, uint16_t changed)
+{
 	for (size_t i = 0; i < debo_slot_count; i++) {
 		debo_slot_t *slot = &debo_slots[i];
 		if (slot->id == DEBO_PIN_NONE) continue; // unused
+		if (slot->port != port || !(slot->pin & changed)) continue;
+
+		if (port->state & slot->pin) {
+			slot->held = 0;
+			slot->next_repeat = slot->repeat_delay;
+			post_event(slot, DEBO_EV_PRESS);
+		} else {
+			post_event(slot, DEBO_EV_RELEASE);
+		}
+	}
+}
+
 
-		bool state = HAL_GPIO_ReadPin(slot->GPIOx, slot->pin);
-		if (slot->invert) state = !state;
+/** Count hold time of active pins, post long-press and repeat events */
+static void update_held(void)
+{
+	for (size_t i = 0; i < debo_slot_count; i++) {
+		debo_slot_t *slot = &debo_slots[i];
+		if (slot->id == DEBO_PIN_NONE) continue; // unused
+		if (slot->long_time == 0 && slot->repeat_delay == 0) continue;
+		if (!(slot->port->state & slot->pin)) continue; // not held
 
-		if (slot->state != state) {
-			if (state == 0) {
-				// falling
+		slot->held++;
 
-				if (slot->counter_0++ == slot->debo_time) {
-					slot->state = 0;
+		if (slot->held == slot->long_time) {
+			post_event(slot, DEBO_EV_LONG);
+		}
 
-					if (slot->callback != NULL) {
-						slot->callback(slot->cb_payload, false);
-					}
-				}
-			} else {
-				// rising
+		if (slot->repeat_delay != 0 && slot->held == slot->next_repeat) {
+			slot->next_repeat += slot->repeat_interval;
+			post_event(slot, DEBO_EV_REPEAT);
+		}
+	}
+}
 
-				if (slot->counter_1++ == slot->debo_time) {
-					slot->state = 1;
 
-					if (slot->callback != NULL) {
-						slot->callback(slot->cb_payload, true);
-					}
-				}
-			}
-		} else {
-			// reset counters
-			slot->counter_0 = 0;
-			slot->counter_1 = 0;
+/** Callback that must be called every 1 ms */
+void debo_periodic_task(void *unused)
+{
+	UNUSED(unused);
+
+	for (size_t i = 0; i < debo_slot_count; i++) {
+		debo_port_t *port = &debo_ports[i];
+		if (port->mask == 0) continue; // unused
+
+		// one read for all pins of the port
+		uint16_t state = (uint16_t) (port->GPIOx->IDR ^ port->invert);
+		uint16_t diff = (state ^ port->state) & port->mask;
+
+		// pins whose counter reached the debounce time
+		uint16_t ne = 0;
+		for (int b = 0; b < DEBO_CNT_BITS; b++) {
+			ne |= port->cnt[b] ^ port->thr[b];
+		}
+		uint16_t changed = diff & ~ne;
+
+		// count up where the pin differs from state, reset the rest
+		uint16_t carry = diff;
+		uint16_t keep = diff & ~changed;
+		for (int b = 0; b < DEBO_CNT_BITS; b++) {
+			uint16_t c = port->cnt[b];
+			port->cnt[b] = (c ^ carry) & keep;
+			carry &= c;
+		}
+
+		if (changed) {
+			port->state ^= changed;
+			notify_changes(port, changed);
 		}
 	}
+
+	update_held();
+}
+
+
+/** Dispatch queued events, called from the main loop */
+void debo_process_events(void)
+{
+	while (debo_queue_tail != debo_queue_head) {
+		uint32_t tail = debo_queue_tail;
+		__DMB();
+		debo_queued_t item = debo_queue[tail & (DEBO_QUEUE_LEN - 1)];
+		__DMB(); // copy the item out before freeing its slot
+		debo_queue_tail = tail + 1;
+
+		item.callback(item.cb_payload, item.event);
+	}
 }
 
 
@@ -146,7 +313,7 @@ bool debo_pin_state(debo_id_t pin_id)
 		debo_slot_t *slot = &debo_slots[i];
 		if (slot->id != pin_id) continue;
 
-		return slot->state;
+		return (slot->port->state & slot->pin) != 0;
 	}
 
 	return false;
@@ -167,6 +334,20 @@ bool debo_remove_pin(debo_id_t pin_id)
 		if (slot->id != pin_id) continue;
 
 		slot->id = DEBO_PIN_NONE;
+
+		// release the pin, unless another slot watches it too
+		debo_port_t *port = slot->port;
+		uint16_t pin = slot->pin;
+		for (size_t j = 0; j < debo_slot_count; j++) {
+			debo_slot_t *other = &debo_slots[j];
+			if (other->id != DEBO_PIN_NONE && other->port == port) {
+				pin &= ~other->pin;
+			}
+		}
+
+		port->mask &= ~pin;
+		if (port->mask == 0) port->GPIOx = NULL;
+
 		return true;
 	}
 
@@ -5,6 +5,10 @@
 #include "stm32f1xx_hal.h"
 
 // Debouncer requires that you setup SysTick first.
+// Pins are grouped by GPIO port, each port is sampled once per ms.
+//
+// Callbacks are not run in the SysTick interrupt, events are queued
+// and dispatched by debo_process_events() - call it in the main loop.
 
 /** Debounced pin ID - used for state readout */
 typedef uint32_t debo_id_t;
@@ -23,13 +27,25 @@ typedef uint32_t debo_id_t;
 void debounce_init(size_t pin_count);
 
 
+/** Debouncer event type, passed to the callback */
+typedef enum {
+	DEBO_EV_PRESS,   ///< pin became active (HIGH after inversion)
+	DEBO_EV_RELEASE, ///< pin became inactive
+	DEBO_EV_LONG,    ///< pin held active for long_time
+	DEBO_EV_REPEAT,  ///< auto-repeat while the pin is held active
+} debo_event_t;
+
+
 typedef struct {
 	GPIO_TypeDef *GPIOx;          ///< GPIO base
 	uint16_t pin;                 ///< pin mask
 	bool invert;                  ///< invert value read from GPIO (button to ground)
-	ms_time_t debo_time;          ///< debounce time in ms, 0 = default (20 ms)
+	ms_time_t debo_time;          ///< debounce time in ms, 0 = default (20 ms), max 255 ms
+	ms_time_t long_time;          ///< hold time for DEBO_EV_LONG in ms, 0 = disabled
+	ms_time_t repeat_delay;       ///< hold time before the first DEBO_EV_REPEAT in ms, 0 = disabled
+	ms_time_t repeat_interval;    ///< interval of the following DEBO_EV_REPEAT events in ms
 	uint32_t cb_payload;          ///< Value passed to the callback func
-	void (*callback)(uint32_t, bool); ///< callback
+	void (*callback)(uint32_t, debo_event_t); ///< callback
 } debo_init_t;
 
 
@@ -42,6 +58,22 @@ typedef struct {
 debo_id_t debo_register_pin(debo_init_t *init_struct);
 
 
+/**
+ * @brief Sample the pins, registered as a 1 ms task by debounce_init().
+ *
+ * Not to be called by the user, exposed for the benchmark (bench.h).
+ */
+void debo_periodic_task(void *unused);
+
+
+/**
+ * @brief Run callbacks for queued events.
+ *
+ * Must be called from the main loop, not from an interrupt.
+ */
+void debo_process_events(void);
+
+
 /**
  * @brief Check if a pin is high
  * @param pin_id : Slot ID
@@ -0,0 +1,30 @@
+#include "decimator.h"
+#include "ramfunc.h"
+
+
+RAMFUNC void decimate(const uint32_t *in, uint32_t *out, uint32_t out_count, uint32_t ratio)
+{
+	// sum of `ratio` 12-bit samples, shifted up to 16 bits
+	const uint32_t shift = 4 - __builtin_ctz(ratio);
+
+	if (ratio < 4) {
+		for (uint32_t i = 0; i < out_count; i++) {
+			uint32_t acc = 0;
+			for (uint32_t k = 0; k < ratio; k++) {
+				acc += *in++;
+			}
+			*out++ = acc << shift;
+		}
+		return;
+	}
+
+	// unrolled by 4, the compiler makes it a load-multiple and 4 adds
+	for (uint32_t i = 0; i < out_count; i++) {
+		uint32_t acc = 0;
+		for (uint32_t k = 0; k < ratio; k += 4) {
+			acc += in[0] + in[1] + in[2] + in[3];
+			in += 4;
+		}
+		*out++ = acc << shift;
+	}
+}
@@ -0,0 +1,30 @@
+#ifndef DECIMATOR_H
+#define DECIMATOR_H
+
+/**
+ * Boxcar (first order CIC) decimator for packed sample pairs.
+ *
+ * Each input word carries two 12-bit samples, one per halfword. The sum of
+ * 16 of them still fits a halfword, so both channels are accumulated with
+ * a single 32-bit add per word, and the sums are scaled to 16 bits.
+ *
+ * Averaging N samples of a noisy signal adds log4(N) bits of resolution:
+ * 1 bit at 4x, 2 bits at 16x. The sinc response of the boxcar is a weak
+ * anti-alias filter, sufficient at these ratios for a visualiser.
+ */
+
+#include <stdint.h>
+
+/** Highest decimation ratio, limited by the halfword accumulator */
+#define DECIM_MAX_RATIO 16
+
+/**
+ * @brief Decimate a block of sample pairs
+ * @param in : input words (12-bit samples), out_count * ratio long
+ * @param out : output words (16-bit samples)
+ * @param out_count : number of output words
+ * @param ratio : 1, 2, 4, 8 or 16; 1 only scales the samples
+ */
+void decimate(const uint32_t *in, uint32_t *out, uint32_t out_count, uint32_t ratio);
+
+#endif // DECIMATOR_H
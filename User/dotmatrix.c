@@ -1,11 +1,12 @@
 #include <string.h>
 #include <stdbool.h>
 #include "dotmatrix.h"
-#include "malloc_safe.h"
+#include "arena.h"
+#include "ramfunc.h"
 
 DotMatrix_Cfg* dmtx_init(DotMatrix_Init *init)
 {
-	DotMatrix_Cfg *disp = calloc_s(1, sizeof(DotMatrix_Cfg));
+	DotMatrix_Cfg *disp = arena_calloc(1, sizeof(DotMatrix_Cfg));
 
 	disp->drv.SPIx = init->SPIx;
 	disp->drv.CS_GPIOx = init->CS_GPIOx;
@@ -14,7 +15,10 @@ DotMatrix_Cfg* dmtx_init(DotMatrix_Init *init)
 	disp->cols = init->cols;
 	disp->rows = init->rows;
 
-	disp->screen = calloc_s(init->cols * init->rows * 8, 1); // 8 bytes per driver
+	assert_param(init->cols <= 4); // a row must fit in a word
+
+	disp->fb = arena_calloc(init->rows * 8, sizeof(uint32_t)); // 8 rows per driver
+	disp->screen = arena_calloc(init->cols * init->rows * 8, 1); // 8 bytes per driver
 
 	max2719_cmd_all(&disp->drv, MAX2719_CMD_DECODE_MODE, 0x00); // no decode
 	max2719_cmd_all(&disp->drv, MAX2719_CMD_SCAN_LIMIT, 0x07); // scan all 8
@@ -30,17 +34,51 @@ DotMatrix_Cfg* dmtx_init(DotMatrix_Init *init)
 	return disp;
 }
 
+RAMFUNC void dmtx_pack(DotMatrix_Cfg* disp)
+{
+	const uint32_t chain_len = disp->drv.chain_len;
+
+	for (uint32_t y = 0; y < disp->rows * 8; y++) {
+		uint32_t row = disp->fb[y];
+
+		// digit (y & 7) of the drivers in driver row (y >> 3)
+		uint8_t *cell = &disp->screen[(y & 7) * chain_len + (y >> 3) * disp->cols];
+
+		for (uint32_t cx = 0; cx < disp->cols; cx++) {
+			cell[cx] = (uint8_t) row;
+			row >>= 8;
+		}
+	}
+}
+
 void dmtx_show(DotMatrix_Cfg* disp)
 {
+	dmtx_pack(disp);
+
 	for (uint8_t i = 0; i < 8; i++) {
 		// show each digit's array in turn
 		max2719_cmd_all_data(&disp->drv, MAX2719_CMD_DIGIT0+i, disp->screen + (i * disp->drv.chain_len));
 	}
 }
 
+uint32_t dmtx_shown_row(DotMatrix_Cfg* disp, uint32_t y)
+{
+	if (y >= disp->rows * 8) return 0;
+
+	// reverse of dmtx_pack()
+	const uint8_t *cell = &disp->screen[(y & 7) * disp->drv.chain_len + (y >> 3) * disp->cols];
+
+	uint32_t row = 0;
+	for (uint32_t cx = 0; cx < disp->cols; cx++) {
+		row |= (uint32_t) cell[cx] << (cx * 8);
+	}
+
+	return row;
+}
+
 void dmtx_clear(DotMatrix_Cfg* disp)
 {
-	memset(disp->screen, 0, disp->drv.chain_len*8);
+	memset(disp->fb, 0, disp->rows * 8 * sizeof(uint32_t));
 }
 
 void dmtx_intensity(DotMatrix_Cfg* disp, uint8_t intensity)
@@ -54,75 +92,105 @@ void dmtx_blank(DotMatrix_Cfg* disp, bool blank)
 }
 
 /**
- * @brief Get a cell pointer
+ * @brief Get a framebuffer row pointer
  * @param disp : driver inst
  * @param x : x coord
  * @param y : y coord
- * @param xd : pointer to store the offset in the cell
- * @return cell ptr
+ * @return row ptr, NULL if out of range
  */
-static uint8_t* cell_ptr(DotMatrix_Cfg* disp, int32_t x, int32_t y, uint8_t *xd)
+static inline uint32_t* row_ptr(DotMatrix_Cfg* disp, int32_t x, int32_t y)
 {
 	if (x < 0 || y < 0) return NULL;
 	if ((uint32_t)x >= disp->cols*8 || (uint32_t)y >= disp->rows*8) return NULL;
 
-	uint32_t cell_x = (uint32_t)x >> 3;
-	*xd = x & 7;
-
-	// resolve cell
-	uint32_t digit = y & 7;
-	cell_x += ((uint32_t)y >> 3) * disp->cols;
-
-	uint32_t cell_idx = (digit * disp->drv.chain_len) + cell_x;
-
-	return &disp->screen[cell_idx];
+	return &disp->fb[y];
 }
 
 
 bool dmtx_get(DotMatrix_Cfg* disp, int32_t x, int32_t y)
 {
-	uint8_t xd;
-	uint8_t *cell = cell_ptr(disp, x, y, &xd);
-	if (cell == NULL) return 0;
+	uint32_t *row = row_ptr(disp, x, y);
+	if (row == NULL) return 0;
 
-	return (*cell >> xd) & 1;
+	return (*row >> x) & 1;
 }
 
 
 void dmtx_toggle(DotMatrix_Cfg* disp, int32_t x, int32_t y)
 {
-	uint8_t xd;
-	uint8_t *cell = cell_ptr(disp, x, y, &xd);
-	if (cell == NULL) return;
+	uint32_t *row = row_ptr(disp, x, y);
+	if (row == NULL) return;
 
-	*cell ^= 1 << xd;
+	*row ^= 1UL << x;
 }
 
 
 void dmtx_set(DotMatrix_Cfg* disp, int32_t x, int32_t y, bool bit)
 {
-	uint8_t xd;
-	uint8_t *cell = cell_ptr(disp, x, y, &xd);
-	if (cell == NULL) return;
+	uint32_t *row = row_ptr(disp, x, y);
+	if (row == NULL) return;
 
 	if (bit) {
-		*cell |= 1 << xd;
+		*row |= 1UL << x;
 	} else {
-		*cell &= ~(1 << xd);
+		*row &= ~(1UL << x);
 	}
 }
 
-void dmtx_set_block(DotMatrix_Cfg* disp, int32_t startX, int32_t startY, uint32_t *data_rows, uint32_t width, uint16_t height)
+/**
+ * @brief Copy a bitmap to the framebuffer, one word op per row
+ * @param or_mode : OR the bits in, otherwise the block area is overwritten
+ */
+static void blit(DotMatrix_Cfg* disp, int32_t startX, int32_t startY,
+				 const uint32_t *data_rows, uint32_t width, uint16_t height, bool or_mode)
 {
-	for (uint32_t y = 0; y < height; y++) {
-		uint32_t row = data_rows[y];
+	const int32_t screen_w = disp->cols * 8;
+	const int32_t screen_h = disp->rows * 8;
+
+	if (width == 0 || width > 32) return;
+	if (startX >= screen_w || startX + (int32_t)width <= 0) return;
+
+	// bitmap bit (width - 1 - x) goes to screen bit (startX + x)
+	const uint32_t rshift = 32 - width;
+	uint32_t mask = 0xFFFFFFFF >> rshift;
+
+	int32_t lshift = startX;
+	if (lshift >= 0) {
+		mask <<= lshift;
+	} else {
+		mask >>= -lshift;
+	}
 
-		for (uint32_t x = 0; x < width; x++) {
-			int xx = startX + (int)x;
-			int yy = startY + (int)y;
-			bool val = (row >> (width - x - 1)) & 1;
+	if (screen_w < 32) mask &= (1UL << screen_w) - 1;
 
-			dmtx_set(disp, xx, yy, val);
+	for (uint32_t y = 0; y < height; y++) {
+		int32_t yy = startY + (int32_t)y;
+		if (yy < 0) continue;
+		if (yy >= screen_h) break;
+
+		// reverse so the bitmap's leftmost pixel is in bit 0
+		uint32_t bits = __RBIT(data_rows[y]) >> rshift;
+		if (lshift >= 0) {
+			bits <<= lshift;
+		} else {
+			bits >>= -lshift;
+		}
+		bits &= mask;
+
+		if (or_mode) {
+			disp->fb[yy] |= bits;
+		} else {
+			disp->fb[yy] = (disp->fb[yy] & ~mask) | bits;
 		}
 	}
 }
+
+void dmtx_set_block(DotMatrix_Cfg* disp, int32_t startX, int32_t startY, const uint32_t *data_rows, uint32_t width, uint16_t height)
+{
+	blit(disp, startX, startY, data_rows, width, height, false);
+}
+
+void dmtx_or_block(DotMatrix_Cfg* disp, int32_t startX, int32_t startY, const uint32_t *data_rows, uint32_t width, uint16_t height)
+{
+	blit(disp, startX, startY, data_rows, width, height, true);
+}
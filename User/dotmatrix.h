@@ -8,8 +8,9 @@
 
 typedef struct {
 	MAX2719_Cfg drv;
-	uint8_t *screen; /*!< Screen array, organized as series of [all #1 digits], [all #2 digits] ... */
-	uint32_t cols; /*!< Number of drivers horizontally */
+	uint32_t *fb; /*!< Drawing surface, one word per pixel row, bit N is the pixel at X=N */
+	uint8_t *screen; /*!< Transmit buffer, organized as series of [all #1 digits], [all #2 digits] ... */
+	uint32_t cols; /*!< Number of drivers horizontally (max 4, the rows are 32 bits) */
 	uint32_t rows; /*!< Number of drivers vertically */
 } DotMatrix_Cfg;
 
@@ -29,10 +30,35 @@ DotMatrix_Cfg* dmtx_init(DotMatrix_Init *init);
 
 /**
  * @brief Display the whole screen array
+ *
+ * The framebuffer is converted to the transmit buffer layout first.
+ *
  * @param dmtx : driver struct
  */
 void dmtx_show(DotMatrix_Cfg* disp);
 
+/**
+ * @brief Convert the row-major framebuffer to the digit-major transmit buffer
+ *
+ * Done by dmtx_show(), public for the benchmark.
+ *
+ * @param disp : driver struct
+ */
+void dmtx_pack(DotMatrix_Cfg* disp);
+
+/**
+ * @brief Get a pixel row of the last shown frame
+ *
+ * The row is decoded from the transmit buffer, so it shows what was
+ * actually sent to the drivers (unlike the framebuffer, which may already
+ * hold the next frame).
+ *
+ * @param disp : driver struct
+ * @param y : pixel Y
+ * @return the row in framebuffer format, 0 if out of range
+ */
+uint32_t dmtx_shown_row(DotMatrix_Cfg* disp, uint32_t y);
+
 /** Set intensity 0-16 */
 void dmtx_intensity(DotMatrix_Cfg* disp, uint8_t intensity);
 
@@ -51,8 +77,23 @@ void dmtx_set(DotMatrix_Cfg* disp, int32_t x, int32_t y, bool bit);
 /** Get a single bit */
 bool dmtx_get(DotMatrix_Cfg* disp, int32_t x, int32_t y);
 
-/** Set a block using array of row data */
-void dmtx_set_block(DotMatrix_Cfg* disp, int32_t startX, int32_t startY, uint32_t *data_rows, uint32_t width, uint16_t height);
+/**
+ * @brief Set a block using array of row data
+ *
+ * Bit (width - 1) of a row is the leftmost pixel, data_rows[0] is the row at startY.
+ * The block is clipped to the screen, pixels under it are overwritten.
+ *
+ * @param disp : driver struct
+ * @param startX : left edge
+ * @param startY : first row
+ * @param data_rows : rows of the block
+ * @param width : block width, max 32
+ * @param height : block height
+ */
+void dmtx_set_block(DotMatrix_Cfg* disp, int32_t startX, int32_t startY, const uint32_t *data_rows, uint32_t width, uint16_t height);
+
+/** OR a block into the screen (like dmtx_set_block(), but zeros are transparent) */
+void dmtx_or_block(DotMatrix_Cfg* disp, int32_t startX, int32_t startY, const uint32_t *data_rows, uint32_t width, uint16_t height);
 
 /** Toggle a single bit */
 void dmtx_toggle(DotMatrix_Cfg* disp, int32_t x, int32_t y);
@@ -0,0 +1,55 @@
+#include "dsp.h"
+#include "capture.h"
+#include "ramfunc.h"
+
+
+RAMFUNC void dsp_samples_to_float(uint32_t *buf, uint32_t count)
+{
+	float *out = (float *) buf;
+
+	// Convert to float
+	for (uint32_t i = 0; i < count; i++) {
+		out[i] = (float) SAMPLE_L(buf[i]);
+	}
+
+	// Obtain mean value
+	float mean;
+	arm_mean_f32(out, count, &mean);
+
+	// Subtract mean from all samples
+	for (uint32_t i = 0; i < count; i++) {
+		out[i] -= mean;
+	}
+}
+
+
+RAMFUNC void dsp_spread_for_fft(float *buf, const float *window, uint32_t count)
+{
+	for (int32_t i = count - 1; i >= 0; i--) {
+		buf[i * 2 + 1] = 0;              // imaginary
+		buf[i * 2] = buf[i] * window[i]; // real
+	}
+}
+
+
+uint32_t dsp_spectrum(uint32_t *buf, const fft_config_t *cfg, float gain, mag_method_t method)
+{
+	float *bins = (float *) buf;
+	const uint32_t bin_count = cfg->fft_len / 2;
+
+	dsp_samples_to_float(buf, cfg->fft_len);
+	dsp_spread_for_fft(bins, cfg->window, cfg->fft_len);
+
+	arm_cfft_f32(cfg->cfft, bins, 0, true); // bit reversed FFT
+	magnitude(bins, bins, bin_count, method); // extract real values
+
+	// 1/N makes the peak height of a tone independent of the FFT size
+	float factor = gain / (cfg->fft_len * FFT_WINDOW_GAIN);
+	if (method == MAG_SQUARED) factor *= factor;
+
+	for (uint32_t i = 0; i < bin_count; i++) {
+		bins[i] *= factor;
+	}
+
+	return bin_count;
+}
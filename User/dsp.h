@@ -0,0 +1,49 @@
+#ifndef DSP_H
+#define DSP_H
+
+/**
+ * The spectrum pipeline, from captured sample words to normalised bins.
+ *
+ * Free of HAL and display code (only CMSIS-DSP), so it builds for the host
+ * as well; feed it a buffer of sample words and compare the bins. On the
+ * host, arm_bitreversal_32 (assembly in CMSIS-DSP) needs a C stand-in,
+ * see test/support/host_bitreversal.c.
+ *
+ * All steps work in place: the buffer holds sample words on input and
+ * floats afterwards, and must have room for 2 * fft_len floats.
+ */
+
+#include <stdint.h>
+#include "fft_config.h"
+#include "magnitude.h"
+
+/**
+ * @brief Convert the left channel to float and remove the DC offset
+ * @param buf : sample words on input, floats on output
+ * @param count : number of samples
+ */
+void dsp_samples_to_float(uint32_t *buf, uint32_t count);
+
+/**
+ * @brief Apply a window and interleave the samples with zeros (imaginary parts)
+ * @param buf : count real samples on input, count complex values on output
+ * @param window : window, count long
+ * @param count : number of samples
+ */
+void dsp_spread_for_fft(float *buf, const float *window, uint32_t count);
+
+/**
+ * @brief Compute the normalised spectrum of a frame
+ *
+ * A full scale sine (16-bit) peaks at 16384 * gain in its bin regardless
+ * of the FFT size; with MAG_SQUARED the bins hold the square of that.
+ *
+ * @param buf : cfg->fft_len sample words on input, bins on output
+ * @param cfg : FFT configuration
+ * @param gain : multiplier of the magnitudes
+ * @param method : magnitude method
+ * @return number of bins, fft_len / 2
+ */
+uint32_t dsp_spectrum(uint32_t *buf, const fft_config_t *cfg, float gain, mag_method_t method);
+
+#endif // DSP_H
@@ -0,0 +1,49 @@
+#include <string.h>
+#include "fastlog.h"
+
+/** 256 * log2(1 + (m + 0.5) / 64), the mantissa part in Q8 */
+static const uint8_t mantissa_log2[64] = {
+	3, 9, 14, 20, 25, 30, 36, 41, 46, 51, 56, 61, 66, 71, 75, 80,
+	85, 89, 94, 98, 103, 107, 111, 116, 120, 124, 128, 132, 136, 140, 144, 148,
+	152, 155, 159, 163, 167, 170, 174, 178, 181, 185, 188, 192, 195, 198, 202, 205,
+	208, 212, 215, 218, 221, 224, 228, 231, 234, 237, 240, 243, 246, 249, 252, 255,
+};
+
+
+int32_t fastlog2_u32(uint32_t x)
+{
+	if (x == 0) return FASTLOG_ZERO;
+
+	const uint32_t lz = __builtin_clz(x);
+
+	// normalize the leading one to bit 31, take the next 6 bits
+	const uint32_t m = ((x << lz) >> 25) & 63;
+
+	return (int32_t) ((31 - lz) << 8) + mantissa_log2[m];
+}
+
+
+int32_t fastlog2_f32(float x)
+{
+	uint32_t bits;
+	memcpy(&bits, &x, sizeof(bits)); // no float maths needed
+
+	if ((int32_t) bits <= 0) return FASTLOG_ZERO; // negative or zero
+
+	const int32_t exponent = (int32_t) (bits >> 23) - 127;
+	const uint32_t m = (bits >> 17) & 63;
+
+	return (exponent << 8) + mantissa_log2[m];
+}
+
+
+void logscale_init(logscale_t *ls, float top, float range_db, uint32_t rows, bool power)
+{
+	// dB per one step of log2
+	const float db_per_log2 = power ? 3.0103f : 6.0206f;
+
+	ls->top = fastlog2_f32(top);
+	ls->row = (int32_t) (range_db / rows / db_per_log2 * 256 + 0.5f);
+	if (ls->row < 1) ls->row = 1;
+	ls->rows = rows;
+}
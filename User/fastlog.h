@@ -0,0 +1,51 @@
+#ifndef FASTLOG_H
+#define FASTLOG_H
+
+/**
+ * Fast base 2 logarithm and a log (dB) scale for bar heights.
+ *
+ * log2 = position of the leading one (CLZ, or the float exponent)
+ * + a 64 entry table of the mantissa. Results are Q8 fixed point; the
+ * error is under 0.013, i.e. below 0.08 dB on a magnitude.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/** Returned for zero and negative inputs */
+#define FASTLOG_ZERO (-0x7FFFFF)
+
+/** log2(x) in Q8, FASTLOG_ZERO for 0 */
+int32_t fastlog2_u32(uint32_t x);
+
+/** log2(x) in Q8 from the float bits, FASTLOG_ZERO for x <= 0 */
+int32_t fastlog2_f32(float x);
+
+/** Log scale mapping values to rows */
+typedef struct {
+	int32_t top; //!< Q8 log2 of the value at the top of the scale
+	int32_t row; //!< Q8 log2 per row
+	uint32_t rows;
+} logscale_t;
+
+/**
+ * @brief Set up a log scale
+ * @param ls : scale to init
+ * @param top : value shown as full height
+ * @param range_db : range of the scale (dB), from the top down to the floor
+ * @param rows : full height
+ * @param power : the values are squared magnitudes (10 log10), otherwise magnitudes (20 log10)
+ */
+void logscale_init(logscale_t *ls, float top, float range_db, uint32_t rows, bool power);
+
+/** Get the height of a value on a log scale, 0..rows */
+static inline uint32_t logscale_height(const logscale_t *ls, int32_t value_log2)
+{
+	const int32_t below = ls->top - value_log2;
+	if (below <= 0) return ls->rows;
+
+	const uint32_t down = (uint32_t) below / ls->row;
+	return down >= ls->rows ? 0 : ls->rows - down;
+}
+
+#endif // FASTLOG_H
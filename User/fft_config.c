@@ -0,0 +1,18 @@
+#include <arm_const_structs.h>
+#include "fft_config.h"
+#include "fft_windows.h"
+
+static const fft_config_t configs[FFT_CONFIG_COUNT] = {
+	{64, "FFT 64", &arm_cfft_sR_f32_len64, win_hamming_64},
+	{128, "FFT 128", &arm_cfft_sR_f32_len128, win_hamming_128},
+	{256, "FFT 256", &arm_cfft_sR_f32_len256, win_hamming_256},
+	{512, "FFT 512", &arm_cfft_sR_f32_len512, win_hamming_512},
+	{1024, "FFT 1024", &arm_cfft_sR_f32_len1024, win_hamming_1024},
+};
+
+
+const fft_config_t *fft_config_get(uint32_t index)
+{
+	if (index >= FFT_CONFIG_COUNT) index = FFT_CONFIG_COUNT - 1;
+	return &configs[index];
+}
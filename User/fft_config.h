@@ -0,0 +1,38 @@
+#ifndef FFT_CONFIG_H
+#define FFT_CONFIG_H
+
+/**
+ * FFT lengths selectable at runtime.
+ *
+ * A frame is fft_len samples; a longer FFT gives finer bins at the cost
+ * of latency (fft_len / sample rate). Buffers are sized for FFT_MAX_LEN.
+ */
+
+#include <stdint.h>
+#include <arm_math.h>
+
+#define FFT_MAX_LEN 1024
+
+/** Number of configurations, 64 to 1024 points */
+#define FFT_CONFIG_COUNT 5
+
+/** The default, 256 points */
+#define FFT_CONFIG_DEFAULT 2
+
+/** Coherent gain of the window (mean of the Hamming window) */
+#define FFT_WINDOW_GAIN 0.54f
+
+typedef struct {
+	uint16_t fft_len; //!< complex points, also the frame length in samples
+	const char *name; //!< shown on the OSD
+	const arm_cfft_instance_f32 *cfft; //!< CMSIS radix-4/2 instance
+	const float *window; //!< Hamming window, fft_len long
+} fft_config_t;
+
+/**
+ * @brief Get a configuration
+ * @param index : 0..FFT_CONFIG_COUNT-1, clamped
+ */
+const fft_config_t *fft_config_get(uint32_t index);
+
+#endif // FFT_CONFIG_H
@@ -0,0 +1,107 @@
+#include <string.h>
+#include "font.h"
+
+/** Pack 5 rows of a glyph, top row first, bit 2 is the left column */
+#define GLYPH(r0, r1, r2, r3, r4) (((r0) << 12) | ((r1) << 9) | ((r2) << 6) | ((r3) << 3) | (r4))
+
+#define FONT_FIRST ' '
+#define FONT_LAST '_'
+
+/** 3x5 glyphs, ASCII 32-95 */
+static const uint16_t font_glyphs[FONT_LAST - FONT_FIRST + 1] = {
+	GLYPH(0b000, 0b000, 0b000, 0b000, 0b000), // space
+	GLYPH(0b010, 0b010, 0b010, 0b000, 0b010), // !
+	GLYPH(0b101, 0b101, 0b000, 0b000, 0b000), // "
+	GLYPH(0b101, 0b111, 0b101, 0b111, 0b101), // #
+	GLYPH(0b011, 0b110, 0b010, 0b011, 0b110), // $
+	GLYPH(0b101, 0b001, 0b010, 0b100, 0b101), // %
+	GLYPH(0b010, 0b101, 0b010, 0b101, 0b011), // &
+	GLYPH(0b010, 0b010, 0b000, 0b000, 0b000), // '
+	GLYPH(0b001, 0b010, 0b010, 0b010, 0b001), // (
+	GLYPH(0b100, 0b010, 0b010, 0b010, 0b100), // )
+	GLYPH(0b000, 0b101, 0b010, 0b101, 0b000), // *
+	GLYPH(0b000, 0b010, 0b111, 0b010, 0b000), // +
+	GLYPH(0b000, 0b000, 0b000, 0b010, 0b100), // ,
+	GLYPH(0b000, 0b000, 0b111, 0b000, 0b000), // -
+	GLYPH(0b000, 0b000, 0b000, 0b000, 0b010), // .
+	GLYPH(0b001, 0b001, 0b010, 0b100, 0b100), // /
+	GLYPH(0b111, 0b101, 0b101, 0b101, 0b111), // 0
+	GLYPH(0b010, 0b110, 0b010, 0b010, 0b111), // 1
+	GLYPH(0b111, 0b001, 0b111, 0b100, 0b111), // 2
+	GLYPH(0b111, 0b001, 0b011, 0b001, 0b111), // 3
+	GLYPH(0b101, 0b101, 0b111, 0b001, 0b001), // 4
+	GLYPH(0b111, 0b100, 0b111, 0b001, 0b111), // 5
+	GLYPH(0b111, 0b100, 0b111, 0b101, 0b111), // 6
+	GLYPH(0b111, 0b001, 0b001, 0b010, 0b010), // 7
+	GLYPH(0b111, 0b101, 0b111, 0b101, 0b111), // 8
+	GLYPH(0b111, 0b101, 0b111, 0b001, 0b111), // 9
+	GLYPH(0b000, 0b010, 0b000, 0b010, 0b000), // :
+	GLYPH(0b000, 0b010, 0b000, 0b010, 0b100), // ;
+	GLYPH(0b001, 0b010, 0b100, 0b010, 0b001), // <
+	GLYPH(0b000, 0b111, 0b000, 0b111, 0b000), // =
+	GLYPH(0b100, 0b010, 0b001, 0b010, 0b100), // >
+	GLYPH(0b111, 0b001, 0b011, 0b000, 0b010), // ?
+	GLYPH(0b111, 0b101, 0b111, 0b100, 0b111), // @
+	GLYPH(0b010, 0b101, 0b111, 0b101, 0b101), // A
+	GLYPH(0b110, 0b101, 0b110, 0b101, 0b110), // B
+	GLYPH(0b011, 0b100, 0b100, 0b100, 0b011), // C
+	GLYPH(0b110, 0b101, 0b101, 0b101, 0b110), // D
+	GLYPH(0b111, 0b100, 0b110, 0b100, 0b111), // E
+	GLYPH(0b111, 0b100, 0b110, 0b100, 0b100), // F
+	GLYPH(0b011, 0b100, 0b101, 0b101, 0b011), // G
+	GLYPH(0b101, 0b101, 0b111, 0b101, 0b101), // H
+	GLYPH(0b111, 0b010, 0b010, 0b010, 0b111), // I
+	GLYPH(0b001, 0b001, 0b001, 0b101, 0b010), // J
+	GLYPH(0b101, 0b101, 0b110, 0b101, 0b101), // K
+	GLYPH(0b100, 0b100, 0b100, 0b100, 0b111), // L
+	GLYPH(0b101, 0b111, 0b111, 0b101, 0b101), // M
+	GLYPH(0b110, 0b101, 0b101, 0b101, 0b101), // N
+	GLYPH(0b010, 0b101, 0b101, 0b101, 0b010), // O
+	GLYPH(0b110, 0b101, 0b110, 0b100, 0b100), // P
+	GLYPH(0b010, 0b101, 0b101, 0b110, 0b011), // Q
+	GLYPH(0b110, 0b101, 0b110, 0b101, 0b101), // R
+	GLYPH(0b011, 0b100, 0b010, 0b001, 0b110), // S
+	GLYPH(0b111, 0b010, 0b010, 0b010, 0b010), // T
+	GLYPH(0b101, 0b101, 0b101, 0b101, 0b111), // U
+	GLYPH(0b101, 0b101, 0b101, 0b101, 0b010), // V
+	GLYPH(0b101, 0b101, 0b111, 0b111, 0b101), // W
+	GLYPH(0b101, 0b101, 0b010, 0b101, 0b101), // X
+	GLYPH(0b101, 0b101, 0b010, 0b010, 0b010), // Y
+	GLYPH(0b111, 0b001, 0b010, 0b100, 0b111), // Z
+	GLYPH(0b011, 0b010, 0b010, 0b010, 0b011), // [
+	GLYPH(0b100, 0b100, 0b010, 0b001, 0b001), // backslash
+	GLYPH(0b110, 0b010, 0b010, 0b010, 0b110), // ]
+	GLYPH(0b010, 0b101, 0b000, 0b000, 0b000), // ^
+	GLYPH(0b000, 0b000, 0b000, 0b000, 0b111), // _
+};
+
+
+int32_t font_draw(DotMatrix_Cfg *disp, int32_t x, int32_t y, const char *text)
+{
+	for (; *text; text++, x += FONT_ADVANCE) {
+		char c = *text;
+		if (c >= 'a' && c <= 'z') c -= 'a' - 'A';
+		if (c < FONT_FIRST || c > FONT_LAST) c = '?';
+
+		uint16_t glyph = font_glyphs[c - FONT_FIRST];
+
+		// bottom row first, that's the one at Y
+		uint32_t rows[FONT_H];
+		for (int r = 0; r < FONT_H; r++) {
+			rows[r] = (glyph >> (r * FONT_W)) & 0x7;
+		}
+
+		dmtx_or_block(disp, x, y, rows, FONT_W, FONT_H);
+	}
+
+	return x;
+}
+
+
+uint32_t font_text_width(const char *text)
+{
+	size_t len = strlen(text);
+	if (len == 0) return 0;
+
+	return (uint32_t) (len * FONT_ADVANCE - (FONT_ADVANCE - FONT_W));
+}
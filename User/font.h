@@ -0,0 +1,26 @@
+#ifndef DMTX_FONT_H
+#define DMTX_FONT_H
+
+#include <stdint.h>
+#include "dotmatrix.h"
+
+/** Small bitmap font for the dot matrix, ASCII 32-95 (lowercase is shown as uppercase) */
+
+#define FONT_W 3       /*!< Glyph width */
+#define FONT_H 5       /*!< Glyph height */
+#define FONT_ADVANCE 4 /*!< Glyph width incl. spacing */
+
+/**
+ * @brief Draw text (OR-ed into the screen)
+ * @param disp : display
+ * @param x : left edge
+ * @param y : bottom edge
+ * @param text : text to draw
+ * @return X coordinate after the text
+ */
+int32_t font_draw(DotMatrix_Cfg *disp, int32_t x, int32_t y, const char *text);
+
+/** Get width of a text in pixels */
+uint32_t font_text_width(const char *text);
+
+#endif // DMTX_FONT_H
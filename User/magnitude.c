@@ -0,0 +1,45 @@
+#include <arm_math.h>
+#include "magnitude.h"
+
+// alpha-max-plus-beta-min coefficients (Q15), minimal peak error
+#define AMBM_ALPHA 31471 // 0.96043387
+#define AMBM_BETA 13036  // 0.39782473
+
+
+/** Integer alpha-max-plus-beta-min */
+static void mag_ambm(const float *cplx, float *out, uint32_t count)
+{
+	for (uint32_t i = 0; i < count; i++) {
+		int32_t re = (int32_t) cplx[i * 2];
+		int32_t im = (int32_t) cplx[i * 2 + 1];
+
+		uint32_t a = (uint32_t) (re < 0 ? -re : re);
+		uint32_t b = (uint32_t) (im < 0 ? -im : im);
+
+		uint32_t max = a > b ? a : b;
+		uint32_t min = a > b ? b : a;
+
+		// 64-bit products, UMULL / UMLAL on the M3
+		uint64_t m = (uint64_t) max * AMBM_ALPHA + (uint64_t) min * AMBM_BETA;
+
+		out[i] = (float) (uint32_t) (m >> 15);
+	}
+}
+
+
+void magnitude(const float *cplx, float *out, uint32_t count, mag_method_t method)
+{
+	switch (method) {
+		case MAG_EXACT:
+			arm_cmplx_mag_f32((float *) cplx, out, count);
+			break;
+
+		case MAG_SQUARED:
+			arm_cmplx_mag_squared_f32((float *) cplx, out, count);
+			break;
+
+		case MAG_AMBM:
+			mag_ambm(cplx, out, count);
+			break;
+	}
+}
@@ -0,0 +1,33 @@
+#ifndef MAGNITUDE_H
+#define MAGNITUDE_H
+
+/**
+ * Magnitude stage of the FFT, with cheaper alternatives to the software
+ * sqrt that arm_cmplx_mag_f32() runs for every bin on the FPU-less M3.
+ *
+ * MAG_EXACT    sqrt(re^2 + im^2) via arm_cmplx_mag_f32(). Exact.
+ * MAG_SQUARED  re^2 + im^2, the power. Exact, no sqrt; take the sqrt of
+ *              the few values that need it, or use a power log scale.
+ * MAG_AMBM     alpha * max(|re|,|im|) + beta * min(|re|,|im|) in integer,
+ *              alpha = 0.96043, beta = 0.39782 (Q15). Error -4.0 % .. +4.0 %
+ *              (max error minimised, i.e. about +-0.35 dB).
+ */
+
+#include <stdint.h>
+
+typedef enum {
+	MAG_EXACT,
+	MAG_SQUARED,
+	MAG_AMBM,
+} mag_method_t;
+
+/**
+ * @brief Compute magnitudes of complex values; can be done in place
+ * @param cplx : interleaved complex input, 2 * count floats
+ * @param out : output, count floats
+ * @param count : number of values
+ * @param method : magnitude method
+ */
+void magnitude(const float *cplx, float *out, uint32_t count, mag_method_t method);
+
+#endif // MAGNITUDE_H
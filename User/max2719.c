@@ -2,18 +2,7 @@
 #include <spi.h>
 #include "max2719.h"
 
-// TODO convert to buffer + batch write.
-// TODO store hspi in the max2719 struct, so it can be used.
-
-static inline
-void send_byte(MAX2719_Cfg *inst, uint8_t b)
-{
-	//inst->SPIx->DR = b;
-	//while (!(inst->SPIx->SR & SPI_SR_TXE));
-
-	// FIXME figure out why regular transmit is not working
-	HAL_SPI_Transmit(&hspi1, &b, 1, 10);
-}
+// SPI runs in 16-bit frame mode, one frame = one MAX2719 register write.
 
 
 static inline
@@ -27,55 +16,79 @@ void set_nss(MAX2719_Cfg *inst, bool nss)
 }
 
 
-static void send_word(MAX2719_Cfg *inst, MAX2719_Command cmd, uint8_t data)
+/** Build a register write word */
+static inline
+uint16_t make_word(MAX2719_Command cmd, uint8_t data)
 {
-	send_byte(inst, cmd);
-	send_byte(inst, data);
+	return (uint16_t) ((cmd << 8) | data);
 }
 
 
-void max2719_cmd(MAX2719_Cfg *inst, uint32_t nth, MAX2719_Command cmd, uint8_t data)
+/**
+ * @brief Send a chain write - one word per driver, the last driver's word first
+ * @param inst  : config struct
+ * @param words : words to send
+ */
+static void send_words(MAX2719_Cfg *inst, const uint16_t *words)
 {
+	SPI_TypeDef *SPIx = inst->SPIx;
+
+	// HAL_SPI_Init() leaves the peripheral disabled, HAL_SPI_Transmit() would enable it.
+	// Without this, writes to DR went nowhere.
+	if (!(SPIx->CR1 & SPI_CR1_SPE)) {
+		SPIx->CR1 |= SPI_CR1_SPE;
+	}
+
 	set_nss(inst, 0);
-	while (inst->SPIx->SR & SPI_SR_BSY);
+
+	for (uint32_t i = 0; i < inst->chain_len; i++) {
+		while (!(SPIx->SR & SPI_SR_TXE));
+		SPIx->DR = words[i];
+	}
+
+	// wait for the last frame to leave the shift register
+	while (!(SPIx->SR & SPI_SR_TXE));
+	while (SPIx->SR & SPI_SR_BSY);
+
+	set_nss(inst, 1);
+}
+
+
+void max2719_cmd(MAX2719_Cfg *inst, uint32_t nth, MAX2719_Command cmd, uint8_t data)
+{
+	uint16_t words[inst->chain_len];
 
 	for (uint32_t i = 0; i < inst->chain_len; i++) {
 		if (i == inst->chain_len - nth - 1) {
-			send_word(inst, cmd, data);
+			words[i] = make_word(cmd, data);
 		} else {
-			send_word(inst, MAX2719_CMD_NOOP, 0);
+			words[i] = make_word(MAX2719_CMD_NOOP, 0);
 		}
 	}
 
-	while (inst->SPIx->SR & SPI_SR_BSY);
-	set_nss(inst, 1);
+	send_words(inst, words);
 }
 
 
-
 void max2719_cmd_all(MAX2719_Cfg *inst, MAX2719_Command cmd, uint8_t data)
 {
-	set_nss(inst, 0);
-	while (inst->SPIx->SR & SPI_SR_BSY);
+	uint16_t words[inst->chain_len];
 
 	for (uint32_t i = 0; i < inst->chain_len; i++) {
-		send_word(inst, cmd, data);
+		words[i] = make_word(cmd, data);
 	}
 
-	while (inst->SPIx->SR & SPI_SR_BSY);
-	set_nss(inst, 1);
+	send_words(inst, words);
 }
 
 
 void max2719_cmd_all_data(MAX2719_Cfg *inst, MAX2719_Command cmd, uint8_t *data)
 {
-	set_nss(inst, 0);
-	while (inst->SPIx->SR & SPI_SR_BSY);
+	uint16_t words[inst->chain_len];
 
 	for (uint32_t i = 0; i < inst->chain_len; i++) {
-		send_word(inst, cmd, data[inst->chain_len - i - 1]);
+		words[i] = make_word(cmd, data[inst->chain_len - i - 1]);
 	}
 
-	while (inst->SPIx->SR & SPI_SR_BSY);
-	set_nss(inst, 1);
+	send_words(inst, words);
 }
@@ -0,0 +1,68 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include "stm32f1xx_hal.h"
+#include "meminfo.h"
+#include "arena.h"
+#include "debug.h"
+
+// Symbols from the linker script
+extern uint32_t _estack;
+extern uint32_t _heap_limit;
+extern char end __asm("end");
+
+// Heap top, from syscalls.c
+extern char *_sbrk(int incr);
+
+/** Pattern used to paint the free stack area */
+#define STACK_PAINT 0xC5C5C5C5
+
+/** Words below SP left unpainted, room for the painting function's frame */
+#define STACK_PAINT_MARGIN 16
+
+
+void meminfo_paint_stack(void)
+{
+	uint32_t *sp = (uint32_t *) __get_MSP();
+	uint32_t *p = &_heap_limit;
+
+	while (p < sp - STACK_PAINT_MARGIN) {
+		*p++ = STACK_PAINT;
+	}
+}
+
+
+size_t meminfo_stack_used(void)
+{
+	uint32_t *p = &_heap_limit;
+
+	// find the lowest word the stack has written to
+	while (p < &_estack && *p == STACK_PAINT) p++;
+
+	return (size_t) ((uint8_t *) &_estack - (uint8_t *) p);
+}
+
+
+size_t meminfo_stack_size(void)
+{
+	return (size_t) ((uint8_t *) &_estack - (uint8_t *) &_heap_limit);
+}
+
+
+size_t meminfo_heap_used(void)
+{
+	return (size_t) (_sbrk(0) - &end);
+}
+
+
+size_t meminfo_heap_size(void)
+{
+	return (size_t) ((char *) &_heap_limit - &end);
+}
+
+
+void meminfo_report(void)
+{
+	info("Stack: %d of %d bytes used (high-water)", (int) meminfo_stack_used(), (int) meminfo_stack_size());
+	info("Arena: %d of %d bytes used", (int) arena_used(), (int) arena_size());
+	info("Heap:  %d of %d bytes used", (int) meminfo_heap_used(), (int) meminfo_heap_size());
+}
@@ -0,0 +1,33 @@
+#ifndef MEMINFO_H
+#define MEMINFO_H
+
+/**
+ * RAM usage instrumentation.
+ *
+ * The free RAM between the heap limit and the stack is painted
+ * with a pattern at boot, the stack high-water mark is then found
+ * by looking for the lowest overwritten word.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+
+/** Paint the unused stack area. Call as early as possible. */
+void meminfo_paint_stack(void);
+
+/** Get the maximal stack depth seen so far (bytes) */
+size_t meminfo_stack_used(void);
+
+/** Get the size of the area the stack can grow into (bytes) */
+size_t meminfo_stack_size(void);
+
+/** Get bytes of the newlib heap in use */
+size_t meminfo_heap_used(void);
+
+/** Get the newlib heap capacity */
+size_t meminfo_heap_size(void);
+
+/** Print stack, arena and heap usage to the debug output */
+void meminfo_report(void);
+
+#endif // MEMINFO_H
@@ -0,0 +1,82 @@
+#include "onset.h"
+
+// Per-band state
+static float prev_level[BAND_COUNT];
+static float flux_mean[BAND_COUNT];
+
+static ms_time_t last_frame = 0;
+static ms_time_t last_onset = 0;
+static float strength = 0;
+static float strength_mean = 0;
+static uint32_t count = 0;
+
+
+bool onset_process(const float *levels, ms_time_t now)
+{
+	// one-pole mean, coefficient from the frame interval
+	const float dt = (float) (now - last_frame);
+	const float alpha = dt / (ONSET_MEAN_TAU + dt);
+	last_frame = now;
+
+	float sum = 0;
+	float total = 0;
+	for (int b = 0; b < BAND_COUNT; b++) {
+		total += levels[b];
+
+		float flux = levels[b] - prev_level[b];
+		prev_level[b] = levels[b];
+		if (flux < 0) flux = 0; // only rising energy
+
+		const float excess = flux - ONSET_RATIO * flux_mean[b];
+		if (excess > 0) sum += excess;
+
+		flux_mean[b] += alpha * (flux - flux_mean[b]);
+	}
+
+	strength = sum;
+
+	// adaptive threshold of the total
+	const float thr = ONSET_RATIO * strength_mean + ONSET_MIN_STRENGTH + ONSET_REL_FLOOR * total;
+	strength_mean += alpha * (sum - strength_mean);
+
+	if (sum < thr || now - last_onset < ONSET_REFRACTORY) {
+		return false;
+	}
+
+	last_onset = now;
+	count++;
+	return true;
+}
+
+
+void onset_reset(void)
+{
+	for (int b = 0; b < BAND_COUNT; b++) {
+		prev_level[b] = 0;
+		flux_mean[b] = 0;
+	}
+
+	last_frame = 0;
+	last_onset = 0;
+	strength = 0;
+	strength_mean = 0;
+	count = 0;
+}
+
+
+float onset_strength(void)
+{
+	return strength;
+}
+
+
+ms_time_t onset_last_time(void)
+{
+	return last_onset;
+}
+
+
+uint32_t onset_count(void)
+{
+	return count;
+}
@@ -0,0 +1,61 @@
+#ifndef ONSET_H
+#define ONSET_H
+
+/**
+ * Onset (beat) detection from the band levels, see bands.h.
+ *
+ * Spectral flux: the rise of each band's level since the last frame.
+ * Each band compares its flux with a running mean of its own past flux,
+ * so steady sounds and loud bands don't trigger on their own. The parts
+ * above the thresholds are summed into the onset strength. An onset is
+ * reported when the strength exceeds ONSET_RATIO times its own running
+ * mean plus ONSET_MIN_STRENGTH plus ONSET_REL_FLOOR of the summed band
+ * levels, and the refractory time has passed. The relative floor keeps
+ * the frame to frame ripple of loud steady sounds (window leakage of a
+ * tone, a fraction of a percent) from adding up to an onset.
+ *
+ * Frames need not be evenly spaced, the time constants use timestamps
+ * (the frame clock, see capture_time()).
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "bands.h"
+#include "timebase.h"
+
+/** Time constant of the running means (ms) */
+#define ONSET_MEAN_TAU 1000
+
+/** Threshold, as a multiple of the running mean (per band flux and the total strength) */
+#define ONSET_RATIO 2.0f
+
+/** Onset strength floor, added to the adaptive threshold (band level units) */
+#define ONSET_MIN_STRENGTH 1.0f
+
+/** Onset strength floor relative to the sum of the band levels */
+#define ONSET_REL_FLOOR 0.03f
+
+/** Minimal time between onsets (ms) */
+#define ONSET_REFRACTORY 120
+
+/**
+ * @brief Process a frame
+ * @param levels : band levels, BAND_COUNT long
+ * @param now : frame timestamp (ms)
+ * @return true if an onset was detected
+ */
+bool onset_process(const float *levels, ms_time_t now);
+
+/** Forget the history and the onsets */
+void onset_reset(void);
+
+/** Get the onset strength of the last frame (0 if below the thresholds) */
+float onset_strength(void);
+
+/** Get the time of the last onset (ms) */
+ms_time_t onset_last_time(void);
+
+/** Get the number of onsets so far, to spot new ones */
+uint32_t onset_count(void);
+
+#endif // ONSET_H
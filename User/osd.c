@@ -0,0 +1,51 @@
+#include <string.h>
+#include "osd.h"
+#include "font.h"
+
+/** Message text */
+static char osd_text[OSD_MAX_LEN + 1];
+
+/** Message start and duration, 0 duration = nothing shown */
+static volatile ms_time_t osd_start;
+static volatile ms_time_t osd_duration = 0;
+
+
+void osd_show(const char *text, ms_time_t duration)
+{
+	// the renderer runs in an interrupt, don't let it see a half-written text
+	__disable_irq();
+	strncpy(osd_text, text, OSD_MAX_LEN);
+	osd_text[OSD_MAX_LEN] = 0;
+	osd_start = ms_now();
+	osd_duration = duration;
+	__enable_irq();
+}
+
+
+void osd_render(DotMatrix_Cfg *disp)
+{
+	if (osd_duration == 0) return;
+
+	if (ms_elapsed(osd_start) >= osd_duration) {
+		osd_duration = 0;
+		return;
+	}
+
+	const int32_t screen_w = disp->cols * 8;
+	const int32_t screen_h = disp->rows * 8;
+
+	int32_t w = font_text_width(osd_text);
+	int32_t x = (screen_w - w) / 2;
+	int32_t y = (screen_h - FONT_H) / 2;
+
+	// blank a box with a 1 px border around the text
+	uint32_t box = 0xFFFFFFFF;
+	if (w + 2 < 32) box = ((1UL << (w + 2)) - 1) << (x > 0 ? x - 1 : 0);
+
+	for (int32_t r = y - 1; r <= y + FONT_H; r++) {
+		if (r < 0 || r >= screen_h) continue;
+		disp->fb[r] &= ~box;
+	}
+
+	font_draw(disp, x, y, osd_text);
+}
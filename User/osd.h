@@ -0,0 +1,31 @@
+#ifndef OSD_H
+#define OSD_H
+
+/**
+ * On-screen display - a short message drawn over the visualisation
+ * for a while, e.g. the new value after a button press.
+ *
+ * osd_show() is called from the main loop, osd_render() by the renderer
+ * just before the frame is shown, so the message never holds up a frame.
+ */
+
+#include "dotmatrix.h"
+#include "timebase.h"
+
+/** Max message length (chars) */
+#define OSD_MAX_LEN 8
+
+/** Default message duration (ms) */
+#define OSD_DURATION 1200
+
+/**
+ * @brief Show a message
+ * @param text : message, cut to OSD_MAX_LEN
+ * @param duration : how long to show it (ms)
+ */
+void osd_show(const char *text, ms_time_t duration);
+
+/** Draw the active message, if any, over the framebuffer */
+void osd_render(DotMatrix_Cfg *disp);
+
+#endif // OSD_H
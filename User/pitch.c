@@ -0,0 +1,125 @@
+#include <math.h>
+#include "pitch.h"
+#include "arena.h"
+
+/** Longest lag, at the lowest frequency */
+#define MAX_LAG (PITCH_MAX_LEN / 2)
+
+// 6 KB, allocated by pitch_init()
+static int16_t *decimated;
+static float *diff; // difference function, MAX_LAG + 2 long
+static float *cmnd; // cumulative mean normalised difference, MAX_LAG + 2 long
+
+
+void pitch_init(void)
+{
+	decimated = arena_alloc(PITCH_MAX_LEN * sizeof(int16_t));
+	diff = arena_alloc((MAX_LAG + 2) * sizeof(float));
+	cmnd = arena_alloc((MAX_LAG + 2) * sizeof(float));
+}
+
+
+/** Average groups of `ratio` samples; returns the number of outputs */
+static uint32_t decimate_frame(const float *samples, uint32_t count, uint32_t ratio)
+{
+	const float scale = 1.0f / ratio;
+	const uint32_t n = count / ratio;
+
+	for (uint32_t i = 0; i < n; i++) {
+		float acc = 0;
+		for (uint32_t k = 0; k < ratio; k++) {
+			acc += *samples++;
+		}
+
+		acc *= scale;
+		if (acc > INT16_MAX) acc = INT16_MAX;
+		if (acc < INT16_MIN) acc = INT16_MIN;
+		decimated[i] = (int16_t) acc;
+	}
+
+	return n;
+}
+
+
+/** YIN difference function at one lag, over `window` samples */
+static uint64_t difference(uint32_t lag, uint32_t window)
+{
+	const int16_t *a = decimated;
+	const int16_t *b = decimated + lag;
+	uint64_t sum = 0;
+
+	for (uint32_t j = 0; j < window; j++) {
+		const int32_t d = (int32_t) a[j] - b[j];
+		// |d| reaches 65535, d * d only fits unsigned
+		sum += (uint32_t) d * (uint32_t) d; // multiply-accumulate long
+	}
+
+	return sum;
+}
+
+
+float pitch_detect(const float *samples, uint32_t count, float sample_rate)
+{
+	if (count > PITCH_MAX_LEN) count = PITCH_MAX_LEN;
+
+	uint32_t ratio = (uint32_t) (sample_rate / PITCH_DECIM_RATE);
+	if (ratio < 1) ratio = 1;
+
+	const uint32_t n = decimate_frame(samples, count, ratio);
+	const float rate = sample_rate / ratio;
+
+	// half the frame is the integration window, the other half the lag range
+	const uint32_t window = n / 2;
+
+	uint32_t lag_min = (uint32_t) (rate / PITCH_FREQ_MAX);
+	uint32_t lag_max = (uint32_t) (rate / PITCH_FREQ_MIN);
+	if (lag_min < 2) lag_min = 2;
+	if (lag_max > n - window - 1) lag_max = n - window - 1;
+	if (lag_max <= lag_min + 1) return 0;
+
+	// level gate
+	uint64_t energy = 0;
+	for (uint32_t j = 0; j < window; j++) {
+		energy += (uint32_t) (decimated[j] * decimated[j]);
+	}
+	if (energy < (uint64_t) PITCH_MIN_RMS * PITCH_MIN_RMS * window) return 0;
+
+	// the normalisation needs the running sum from lag 1
+	uint64_t running = 0;
+	uint32_t found = 0;
+
+	cmnd[0] = 1;
+	for (uint32_t lag = 1; lag <= lag_max + 1; lag++) {
+		const uint64_t d = difference(lag, window);
+		running += d;
+		diff[lag] = (float) d;
+		cmnd[lag] = running ? (float) d * lag / (float) running : 1;
+
+		if (lag <= lag_min) continue;
+
+		const uint32_t prev = lag - 1;
+		if (found == 0) {
+			if (prev > lag_min && cmnd[prev] < PITCH_THRESHOLD) {
+				found = prev; // under the threshold, now follow the dip down
+			}
+		}
+
+		if (found != 0) {
+			if (cmnd[lag] < cmnd[found]) {
+				found = lag;
+			} else {
+				break; // bottom of the dip, lag + 1 is computed for the interpolation
+			}
+		}
+	}
+
+	if (found == 0 || found >= lag_max) return 0;
+
+	// parabolic interpolation of the dip, on the plain difference (the normalisation skews it)
+	const float a = diff[found - 1], b = diff[found], c = diff[found + 1];
+	const float den = a - 2 * b + c;
+	float lag = (float) found;
+	if (den > 0) lag += 0.5f * (a - c) / den;
+
+	return rate / lag;
+}
@@ -0,0 +1,48 @@
+#ifndef PITCH_H
+#define PITCH_H
+
+/**
+ * Fundamental frequency estimation with the YIN algorithm
+ * (de Cheveigne & Kawahara, 2002), in integer arithmetic.
+ *
+ * The frame is decimated to about PITCH_DECIM_RATE first, which cuts the
+ * cost of the difference function by the square of the ratio. The lag
+ * search stops at the first dip of the normalised difference under
+ * PITCH_THRESHOLD, so high notes are cheap; the dip is refined with
+ * parabolic interpolation.
+ *
+ * The lowest detectable frequency is limited by the frame: two periods
+ * must fit, e.g. 1024 samples at 20 kHz reach down to 40 Hz.
+ */
+
+#include <stdint.h>
+
+/** Longest frame */
+#define PITCH_MAX_LEN 1024
+
+/** Target sample rate after decimation (Hz) */
+#define PITCH_DECIM_RATE 8000
+
+/** Search range (Hz) */
+#define PITCH_FREQ_MIN 40
+#define PITCH_FREQ_MAX 1200
+
+/** YIN absolute threshold of the normalised difference */
+#define PITCH_THRESHOLD 0.15f
+
+/** Minimal RMS level (16-bit sample units) */
+#define PITCH_MIN_RMS 64
+
+/** Allocate the work buffers (arena), call once at init */
+void pitch_init(void);
+
+/**
+ * @brief Estimate the fundamental frequency
+ * @param samples : DC removed samples (16-bit scale)
+ * @param count : number of samples, at most PITCH_MAX_LEN
+ * @param sample_rate : sample rate (Hz)
+ * @return frequency (Hz), 0 if there's no clear pitch
+ */
+float pitch_detect(const float *samples, uint32_t count, float sample_rate);
+
+#endif // PITCH_H
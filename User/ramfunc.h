@@ -0,0 +1,24 @@
+#ifndef RAMFUNC_H
+#define RAMFUNC_H
+
+/**
+ * Run a function from SRAM.
+ *
+ * At 72 MHz the Flash has 2 wait states, and the prefetch buffer only
+ * helps straight code; a taken branch in a tight loop stalls. SRAM has
+ * no wait states.
+ *
+ * Tagged functions go to the .ramfunc section, which the linker script
+ * places in .data, so the startup copies them to RAM with the data.
+ * Each costs its code size in RAM (and still in Flash), keep it to the hot
+ * loops. Calls between Flash and RAM are out of BL range, the linker adds
+ * long branch veneers (a few cycles per call).
+ *
+ * Hot library code (CMSIS-DSP FFT, soft-float add / multiply) is placed
+ * by object file name in STM32F107VCTx_FLASH.ld.
+ */
+
+/** Place a function in RAM; not inlined, an inlined copy would run from Flash */
+#define RAMFUNC __attribute__((section(".ramfunc"), noinline))
+
+#endif // RAMFUNC_H
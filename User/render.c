@@ -0,0 +1,457 @@
+#include <stdio.h>
+#include <arm_math.h>
+#include <arm_const_structs.h>
+#include "render.h"
+#include "bands.h"
+#include "vu_meter.h"
+#include "stereo.h"
+#include "onset.h"
+#include "tempo.h"
+#include "font.h"
+#include "pitch.h"
+#include "fastlog.h"
+#include "magnitude.h"
+#include "dsp.h"
+#include "capture.h"
+
+// Y axis scaling factors, for 16-bit samples
+#define WAVEFORM_SCALE (0.007f / 16)
+#define FFT_SCALE (0.25f * 0.3f / 16)
+#define FFT_SPINDLE_SCALE_MULT 0.5f
+#define VU_GAIN_REF 5.0f // y_scale with unity gain of the level meter
+
+// dB scale of the spectrum bars: full scale sine at the top with the default y_scale
+#define FFT_DB_TOP (16384.0f * FFT_SCALE * 5.0f)
+#define FFT_DB_RANGE 60.0f
+
+/**
+ * FFT magnitude stage, see magnitude.h. With MAG_SQUARED the bins hold power,
+ * and only the band levels and the displayed bins are square rooted.
+ */
+#define FFT_MAG_METHOD MAG_SQUARED
+#define FFT_BINS_POWER (FFT_MAG_METHOD == MAG_SQUARED)
+
+/** How long the display flashes after a beat (ms) */
+#define BEAT_FLASH_MS 100
+
+/** Display, buffer and callbacks */
+static render_init_t render;
+
+/** The frame being rendered */
+static const render_args_t *frame;
+
+/** Sample rate and frame length the DSP tables are set up for */
+static float sample_rate = 0;
+static uint32_t dsp_frame_len = 0;
+
+/**
+ * Waterfall history, a circular buffer of columns packed in row words:
+ * column k is bit k of each row, wf_head is the newest column.
+ * Scrolling is done by moving the head.
+ */
+static uint32_t wf_rows[SCREEN_H];
+static uint32_t wf_head = 0;
+
+/** Band levels of the last FFT frame */
+static float band_levels[BAND_COUNT];
+
+/** Bar heights of the displayed bins, computed once per frame */
+static uint8_t bar_h[SCREEN_W];
+
+
+void render_init(const render_init_t *init)
+{
+	render = *init;
+}
+
+/** Set up the sample rate and frame length dependent tables */
+static void configure_dsp(float rate, uint32_t frame_len)
+{
+	sample_rate = rate;
+	dsp_frame_len = frame_len;
+
+	bands_configure(rate, frame_len);
+	vu_configure(rate, frame_len);
+}
+
+/** Display waveform preview */
+static void display_wave(void)
+{
+	float *samples_f = (float *) render.samples;
+
+	dsp_samples_to_float(render.samples, frame->fft->fft_len);
+
+	const int n = frame->fft->fft_len;
+	int x_offset = 0;
+
+	for (int i = 1; i < n; i++) {
+		if (samples_f[i] > 0 && samples_f[i - 1] < 0) {
+			x_offset = i;
+			break;
+		}
+	}
+
+	// make sure we're not gonna run out of range
+	if (x_offset >= n - SCREEN_W) {
+		x_offset = 0;
+	}
+
+	float totalmult = WAVEFORM_SCALE * frame->y_scale;
+
+	render.start();
+	for (int i = 0; i < SCREEN_W; i++) {
+		dmtx_set(render.disp, i, 7 + roundf(samples_f[i + x_offset] * totalmult), 1);
+	}
+
+	render.finish();
+}
+
+/** Calculate and display FFT */
+static void calculate_fft(void)
+{
+	const float *bins = (const float *) render.samples;
+
+	dsp_spectrum(render.samples, frame->fft, FFT_SCALE * frame->y_scale, FFT_MAG_METHOD);
+
+	render.start();
+
+	bands_compute(bins, band_levels);
+	if (FFT_BINS_POWER) {
+		// band levels are peaks, the peak power is the square of the peak magnitude
+		for (int b = 0; b < BAND_COUNT; b++) {
+			band_levels[b] = sqrtf(band_levels[b]);
+		}
+	}
+
+	// beat detection runs with every FFT mode; frames are timed by the sample
+	// clock, ms_now() misses ticks while a frame renders in the DMA interrupt
+	onset_process(band_levels, frame->time);
+	tempo_process(onset_strength(), frame->time);
+}
+
+/**
+ * @brief Convert magnitudes of the displayed bins to bar heights, 1..rows
+ * @param mag : magnitudes, or power (squared magnitudes), SCREEN_W long
+ * @param heights : output
+ * @param scale : multiplier to rows of the linear scale (of the magnitude)
+ * @param rows : full height
+ * @param power : the input is power
+ */
+static void bar_heights(const float *mag, uint8_t *heights, float scale, uint32_t rows, bool power)
+{
+	if (frame->db_scale) {
+		float top = FFT_DB_TOP * rows / SCREEN_H / scale;
+		if (power) top *= top;
+
+		logscale_t ls;
+		logscale_init(&ls, top, FFT_DB_RANGE, rows, power);
+
+		for (int x = 0; x < SCREEN_W; x++) {
+			uint32_t h = logscale_height(&ls, fastlog2_f32(mag[x]));
+			heights[x] = h < 1 ? 1 : h;
+		}
+	} else {
+		for (int x = 0; x < SCREEN_W; x++) {
+			float h = 1 + (power ? sqrtf(mag[x]) : mag[x]) * scale;
+			heights[x] = h > rows ? rows : (uint8_t) h;
+		}
+	}
+}
+
+bool render_beat_flash(ms_time_t now)
+{
+	return onset_count() > 0 && now - onset_last_time() < BEAT_FLASH_MS;
+}
+
+/** Render classic FFT */
+static void display_fft(void)
+{
+	bar_heights((const float *) render.samples, bar_h, 1.0f, SCREEN_H, FFT_BINS_POWER);
+
+	for (int x = 0; x < SCREEN_W; x++) {
+		for (int j = 0; j < bar_h[x]; j++) {
+			dmtx_set(render.disp, x, j, 1);
+		}
+	}
+
+	render.finish();
+}
+
+/** Render FFT "spindle" */
+static void display_fft_spindle(void)
+{
+	bar_heights((const float *) render.samples, bar_h, FFT_SPINDLE_SCALE_MULT, SCREEN_H / 2, FFT_BINS_POWER);
+
+	for (int x = 0; x < SCREEN_W; x++) {
+		for (int j = 0; j < bar_h[x]; j++) {
+			dmtx_set(render.disp, x, 7 + j, 1);
+			dmtx_set(render.disp, x, 7 - j, 1);
+		}
+	}
+
+	render.finish();
+}
+
+/** Render a spectrogram, new column on the right, history scrolling left */
+static void display_waterfall(void)
+{
+	const float *levels = band_levels;
+
+	// ordered dither thresholds, gives some shades to the mono display
+	static const float dither[4] = {1.0f, 3.0f, 2.0f, 4.0f};
+
+	wf_head = (wf_head + 1) & (SCREEN_W - 1);
+	const uint32_t bit = 1UL << wf_head;
+
+	for (int y = 0; y < BAND_COUNT; y++) {
+		if (levels[y] > dither[(wf_head + y) & 3]) {
+			wf_rows[y] |= bit;
+		} else {
+			wf_rows[y] &= ~bit;
+		}
+	}
+
+	// rotate so the column after the head (the oldest) lands at X = 0
+	const uint32_t rot = (wf_head + 1) & (SCREEN_W - 1);
+	for (int y = 0; y < SCREEN_H; y++) {
+		render.disp->fb[y] |= rot ? __ROR(wf_rows[y], rot) : wf_rows[y];
+	}
+
+	render.finish();
+}
+
+/** Render level meters - VU (RMS) on the left, PPM (peak) with peak hold on the right */
+static void display_vu(void)
+{
+	vu_process(render.samples, frame->fft->fft_len, frame->y_scale / VU_GAIN_REF);
+
+	const uint32_t vu_bar = 0x00003FFC;  // X 2..13
+	const uint32_t ppm_bar = 0x1FFE0000; // X 17..28
+
+	const uint32_t vu_h = vu_rms_height();
+	const uint32_t ppm_h = vu_peak_height();
+	const uint32_t hold_h = vu_hold_height();
+
+	render.start();
+
+	for (uint32_t y = 0; y < SCREEN_H; y++) {
+		uint32_t row = 0;
+		if (y < vu_h) row |= vu_bar;
+		if (y < ppm_h) row |= ppm_bar;
+		render.disp->fb[y] |= row;
+	}
+
+	if (hold_h > 0) {
+		render.disp->fb[hold_h - 1] |= ppm_bar;
+	}
+
+	render.finish();
+}
+
+/** Render stereo spectrum - left channel growing up from the middle, right channel down */
+static void display_stereo(void)
+{
+	const arm_cfft_instance_f32 *S = frame->fft->cfft;
+	float *samples_f = (float *) render.samples;
+	float mag_l[SCREEN_W];
+	float mag_r[SCREEN_W];
+
+	// both channels in one FFT, L real & R imaginary
+	stereo_to_complex(render.samples, S->fftLen);
+	arm_cfft_f32(S, samples_f, 0, true);
+	stereo_split_mag(samples_f, S->fftLen, mag_l, mag_r, SCREEN_W);
+
+	render.start();
+
+	float factor = (1.0f / S->fftLen) * FFT_SCALE * FFT_SPINDLE_SCALE_MULT * frame->y_scale;
+	uint8_t bar_r[SCREEN_W];
+	bar_heights(mag_l, bar_h, factor, SCREEN_H / 2, false);
+	bar_heights(mag_r, bar_r, factor, SCREEN_H / 2, false);
+
+	for (int x = 0; x < SCREEN_W; x++) {
+		for (int j = 0; j < bar_h[x]; j++) {
+			dmtx_set(render.disp, x, 8 + j, 1);
+		}
+
+		for (int j = 0; j < bar_r[x]; j++) {
+			dmtx_set(render.disp, x, 7 - j, 1);
+		}
+	}
+
+	render.finish();
+}
+
+/**
+ * Render a goniometer (mid on the Y axis, side on the X axis)
+ * with the correlation meter in the bottom row, -1 left, +1 right
+ */
+static void display_phase(void)
+{
+	const uint32_t *samples = render.samples;
+	const int n = frame->fft->fft_len;
+	const float correlation = stereo_correlation(samples, n);
+
+	uint32_t sum_l = 0, sum_r = 0;
+	for (int i = 0; i < n; i++) {
+		sum_l += SAMPLE_L(samples[i]);
+		sum_r += SAMPLE_R(samples[i]);
+	}
+
+	const int32_t mean_l = sum_l / n;
+	const int32_t mean_r = sum_r / n;
+
+	float totalmult = WAVEFORM_SCALE * frame->y_scale * 0.5f;
+
+	render.start();
+
+	for (int i = 0; i < n; i++) {
+		int32_t l = (int32_t) SAMPLE_L(samples[i]) - mean_l;
+		int32_t r = (int32_t) SAMPLE_R(samples[i]) - mean_r;
+
+		int32_t y = 8 + (int32_t) roundf((l + r) * totalmult);
+		if (y < 1) continue; // keep off the meter row
+
+		dmtx_set(render.disp, 16 + (int32_t) roundf((l - r) * totalmult), y, 1);
+	}
+
+	// correlation bar from the centre
+	int32_t len = (int32_t) roundf(correlation * 15);
+	if (len >= 0) {
+		render.disp->fb[0] |= ((1UL << (len + 1)) - 1) << 16;
+	} else {
+		render.disp->fb[0] |= ((1UL << (1 - len)) - 1) << (16 + len);
+	}
+
+	render.finish();
+}
+
+/** Render band levels as bars and the tempo, inverted for a moment on each beat */
+static void display_beat(void)
+{
+	const int max_level = SCREEN_H - FONT_H - 1; // room for the BPM on top
+
+	for (int b = 0; b < BAND_COUNT; b++) {
+		const uint32_t bar = 3UL << (b * 2);
+
+		for (int y = 0; y < max_level && y < band_levels[b]; y++) {
+			render.disp->fb[y] |= bar;
+		}
+	}
+
+	const float bpm = tempo_bpm();
+	if (bpm > 0) {
+		char buf[8];
+		snprintf(buf, sizeof(buf), "%d", (int) roundf(bpm));
+		font_draw(render.disp, 0, SCREEN_H - FONT_H, buf);
+	}
+
+	if (render_beat_flash(frame->time)) {
+		for (int y = 0; y < SCREEN_H; y++) {
+			render.disp->fb[y] ^= 0xFFFFFFFF;
+		}
+	}
+
+	render.finish();
+}
+
+/**
+ * Render the tuner - note name & deviation in cents,
+ * with a needle at the bottom (+-50 cents over the width)
+ */
+static void display_tuner(void)
+{
+	static const char *note_names[12] = {
+		"C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B"
+	};
+
+	dsp_samples_to_float(render.samples, frame->fft->fft_len);
+
+	const float freq = pitch_detect((const float *) render.samples, frame->fft->fft_len, sample_rate);
+
+	render.start();
+
+	// scale ticks at -50, 0, +50 cents
+	render.disp->fb[0] |= (1UL << 0) | (1UL << 16) | (1UL << 31);
+
+	if (freq <= 0) {
+		font_draw(render.disp, 0, 9, "--");
+		render.finish();
+		return;
+	}
+
+	// MIDI note number, A4 = 69 = 440 Hz
+	const float midi = 69 + 12 * log2f(freq / 440.0f);
+	const int note = (int) roundf(midi);
+	const int cents = (int) roundf((midi - note) * 100);
+
+	char buf[16]; // a note name and any int, no truncation
+	snprintf(buf, sizeof(buf), "%s%d", note_names[note % 12], note / 12 - 1);
+	font_draw(render.disp, 0, 9, buf);
+
+	snprintf(buf, sizeof(buf), "%+d", cents);
+	font_draw(render.disp, 14, 9, buf);
+
+	// needle, wider when in tune
+	const int32_t x = 16 + (cents * 15) / 50;
+	const uint32_t needle = (cents >= -5 && cents <= 5) ? (7UL << (x - 1)) : (1UL << x);
+	for (int y = 2; y < 7; y++) {
+		render.disp->fb[y] |= needle;
+	}
+
+	render.finish();
+}
+
+void render_frame(render_mode_t mode, const render_args_t *args)
+{
+	frame = args;
+
+	// the rate and length change at a capture start, catch up with them
+	if (args->sample_rate != sample_rate || args->fft->fft_len != dsp_frame_len) {
+		configure_dsp(args->sample_rate, args->fft->fft_len);
+	}
+
+	switch (mode) {
+		case RENDER_WAVEFORM:
+			display_wave();
+			break;
+
+		case RENDER_SPECTRUM:
+			calculate_fft();
+			display_fft();
+			break;
+
+		case RENDER_SPINDLE:
+			calculate_fft();
+			display_fft_spindle();
+			break;
+
+		case RENDER_WATERFALL:
+			calculate_fft();
+			display_waterfall();
+			break;
+
+		case RENDER_VU:
+			display_vu(); // works on the raw samples, no FFT
+			break;
+
+		case RENDER_STEREO:
+			display_stereo();
+			break;
+
+		case RENDER_PHASE:
+			display_phase(); // raw samples
+			break;
+
+		case RENDER_BEAT:
+			calculate_fft();
+			display_beat();
+			break;
+
+		case RENDER_TUNER:
+			display_tuner();
+			break;
+
+		default:
+			break;
+	}
+}
@@ -0,0 +1,71 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+/**
+ * The render modes: each turns a captured frame into a display frame.
+ *
+ * render_frame() works on the sample buffer given to render_init(); the
+ * FFT modes compute the spectrum in it, in place. The frame is cleared
+ * with the start callback, which may also draw an overlay (user_main.c
+ * draws the button feedback), and shown with the finish callback.
+ *
+ * The visualiser calls it from the capture interrupt, the benchmark
+ * (bench.h) with a display on a null SPI.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "dotmatrix.h"
+#include "timebase.h"
+#include "fft_config.h"
+
+#define SCREEN_W 32
+#define SCREEN_H 16
+
+typedef enum {
+	RENDER_SPECTRUM,
+	RENDER_SPINDLE,
+	RENDER_WAVEFORM,
+	RENDER_WATERFALL,
+	RENDER_VU,
+	RENDER_STEREO,
+	RENDER_PHASE,
+	RENDER_BEAT,
+	RENDER_TUNER,
+	RENDER_MODE_COUNT
+} render_mode_t;
+
+typedef struct {
+	DotMatrix_Cfg *disp;  //!< drawn into
+	uint32_t *samples;    //!< frame buffer of the capture, FFT_MAX_LEN * 2 words
+	void (*start)(void);  //!< clear the frame, may draw an overlay
+	void (*finish)(void); //!< show the frame
+} render_init_t;
+
+/** A captured frame and the settings to render it with */
+typedef struct {
+	const fft_config_t *fft; //!< FFT configuration, its length is the frame length
+	float sample_rate;       //!< sample rate (Hz)
+	ms_time_t time;          //!< frame time by the sample clock, see capture_time()
+	float y_scale;           //!< Y axis scale, 5 is the default
+	bool db_scale;           //!< spectrum bars on a dB scale, otherwise linear
+} render_args_t;
+
+/** Set up the renderers, no allocation */
+void render_init(const render_init_t *init);
+
+/**
+ * @brief Render a frame. The rate and length dependent tables are set up
+ * again when the rate or the length changes.
+ * @param mode : render mode
+ * @param args : the frame
+ */
+void render_frame(render_mode_t mode, const render_args_t *args);
+
+/**
+ * @brief Check if a beat was detected recently, the display flashes
+ * @param now : time by the sample clock
+ */
+bool render_beat_flash(ms_time_t now);
+
+#endif // RENDER_H
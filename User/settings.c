@@ -0,0 +1,243 @@
+#include <stddef.h>
+#include <string.h>
+#include "stm32f1xx_hal.h"
+#include "settings.h"
+#include "timebase.h"
+#include "debug.h"
+
+// Storage region, defined in the linker script (two Flash pages)
+extern uint8_t _settings_start;
+
+#define SETTINGS_PAGE_COUNT 2
+#define SETTINGS_MAGIC (0x5E00 | SETTINGS_VERSION)
+
+/** Record as stored in Flash, programmed halfword by halfword, CRC last */
+typedef struct {
+	uint16_t magic;  ///< SETTINGS_MAGIC, includes the layout version
+	uint16_t seq;    ///< sequence number, incremented with each record
+	settings_t data; ///< payload
+	uint16_t crc;    ///< CRC16 of the above
+	uint16_t unused; ///< padding, left erased
+} settings_record_t;
+
+_Static_assert(sizeof(settings_record_t) % 4 == 0, "Settings record must be whole words");
+
+#define RECORDS_PER_PAGE (FLASH_PAGE_SIZE / sizeof(settings_record_t))
+
+/** Values waiting to be saved */
+static settings_t pending;
+static bool pending_dirty = false;
+static ms_time_t pending_time;
+
+/** Last stored record */
+static uint16_t last_seq = 0;
+static int last_page = -1; // -1 = none
+static settings_t last_data;
+
+
+/** Get a page address */
+static inline const settings_record_t *page_ptr(int page)
+{
+	return (const settings_record_t *) (&_settings_start + page * FLASH_PAGE_SIZE);
+}
+
+
+/** CRC16-CCITT */
+static uint16_t crc16(const uint8_t *data, size_t len)
+{
+	uint16_t crc = 0xFFFF;
+
+	for (size_t i = 0; i < len; i++) {
+		crc ^= (uint16_t) data[i] << 8;
+		for (int b = 0; b < 8; b++) {
+			crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+		}
+	}
+
+	return crc;
+}
+
+
+static uint16_t record_crc(const settings_record_t *rec)
+{
+	return crc16((const uint8_t *) rec, offsetof(settings_record_t, crc));
+}
+
+
+/** Check if a record slot was never written */
+static bool record_erased(const settings_record_t *rec)
+{
+	const uint32_t *words = (const uint32_t *) rec;
+
+	for (size_t i = 0; i < sizeof(settings_record_t) / 4; i++) {
+		if (words[i] != 0xFFFFFFFF) return false;
+	}
+
+	return true;
+}
+
+
+static bool record_valid(const settings_record_t *rec)
+{
+	return rec->magic == SETTINGS_MAGIC && rec->crc == record_crc(rec);
+}
+
+
+/** Sequence number comparison, handles overflow */
+static inline bool seq_newer(uint16_t a, uint16_t b)
+{
+	return (int16_t) (a - b) > 0;
+}
+
+
+/**
+ * Copy the values field by field into zeroed memory. The unnamed bitfield
+ * bits are then always 0, they'd otherwise get into the CRC and the
+ * comparison with the stored values and cause needless writes.
+ */
+static void copy_values(settings_t *dest, const settings_t *src)
+{
+	memset(dest, 0, sizeof(settings_t));
+
+	dest->y_scale = src->y_scale;
+	dest->brightness = src->brightness;
+	dest->render_mode = src->render_mode;
+	dest->capture_preset = src->capture_preset;
+	dest->fft_size = src->fft_size;
+	dest->db_scale = src->db_scale;
+}
+
+
+bool settings_load(settings_t *out)
+{
+	last_page = -1;
+	last_seq = 0;
+
+	for (int page = 0; page < SETTINGS_PAGE_COUNT; page++) {
+		const settings_record_t *rec = page_ptr(page);
+
+		for (size_t i = 0; i < RECORDS_PER_PAGE; i++, rec++) {
+			if (!record_valid(rec)) continue;
+
+			if (last_page == -1 || seq_newer(rec->seq, last_seq)) {
+				last_seq = rec->seq;
+				last_page = page;
+				copy_values(&last_data, &rec->data);
+			}
+		}
+	}
+
+	if (last_page == -1) return false;
+
+	*out = last_data;
+	return true;
+}
+
+
+/** Program a record to Flash, CRC goes last */
+static bool program_record(const settings_record_t *dest, const settings_record_t *rec)
+{
+	const uint16_t *src = (const uint16_t *) rec;
+	uint32_t addr = (uint32_t) dest;
+
+	// all but the padding and CRC
+	size_t count = offsetof(settings_record_t, crc) / 2;
+
+	for (size_t i = 0; i < count; i++) {
+		if (HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD, addr + i * 2, src[i]) != HAL_OK) return false;
+	}
+
+	return HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD, (uint32_t) &dest->crc, rec->crc) == HAL_OK;
+}
+
+
+static bool erase_page(int page)
+{
+	FLASH_EraseInitTypeDef erase;
+	erase.TypeErase = FLASH_TYPEERASE_PAGES;
+	erase.Banks = FLASH_BANK_1;
+	erase.PageAddress = (uint32_t) page_ptr(page);
+	erase.NbPages = 1;
+
+	uint32_t fail_page;
+	return HAL_FLASHEx_Erase(&erase, &fail_page) == HAL_OK;
+}
+
+
+/** Find a free slot in a page, NULL if full */
+static const settings_record_t *find_free_slot(int page)
+{
+	const settings_record_t *rec = page_ptr(page);
+
+	for (size_t i = 0; i < RECORDS_PER_PAGE; i++, rec++) {
+		if (record_erased(rec)) return rec;
+	}
+
+	return NULL;
+}
+
+
+/** Append a record, rotating pages when the active one is full */
+static bool store(const settings_t *values)
+{
+	settings_record_t rec;
+	memset(&rec, 0, sizeof(rec));
+	rec.magic = SETTINGS_MAGIC;
+	rec.seq = (uint16_t) (last_seq + 1);
+	copy_values(&rec.data, values);
+	rec.unused = 0xFFFF; // not programmed, stays erased
+	rec.crc = record_crc(&rec);
+
+	int page = (last_page == -1) ? 0 : last_page;
+
+	HAL_FLASH_Unlock();
+
+	const settings_record_t *slot = find_free_slot(page);
+	if (slot == NULL) {
+		// page full, continue in the other one. The latest record
+		// stays in the old page until the new one is written.
+		page = (page + 1) % SETTINGS_PAGE_COUNT;
+		if (erase_page(page)) {
+			slot = page_ptr(page);
+		}
+	}
+
+	bool suc = (slot != NULL) && program_record(slot, &rec);
+
+	HAL_FLASH_Lock();
+
+	if (suc && record_valid(slot)) {
+		last_seq = rec.seq;
+		last_page = page;
+		last_data = rec.data;
+		return true;
+	}
+
+	return false;
+}
+
+
+void settings_changed(const settings_t *values)
+{
+	copy_values(&pending, values);
+	pending_dirty = true;
+	pending_time = ms_now();
+}
+
+
+void settings_periodic(void)
+{
+	if (!pending_dirty) return;
+	if (ms_elapsed(pending_time) < SETTINGS_SAVE_DELAY) return;
+
+	pending_dirty = false;
+
+	// don't wear the Flash with identical records
+	if (last_page != -1 && memcmp(&pending, &last_data, sizeof(settings_t)) == 0) return;
+
+	if (store(&pending)) {
+		dbg("Settings saved, seq %d", last_seq);
+	} else {
+		error("Settings save failed");
+	}
+}
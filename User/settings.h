@@ -0,0 +1,54 @@
+#ifndef SETTINGS_H
+#define SETTINGS_H
+
+/**
+ * Persistent settings, stored in the last two Flash pages.
+ *
+ * Each save appends a record (sequence number, CRC) to the active page.
+ * When it's full, the other page is erased and used next, so the pages
+ * wear evenly. At boot, the record with the highest sequence number
+ * and a valid CRC wins; a record torn by a power loss is skipped.
+ *
+ * Saving is deferred - it happens in settings_periodic() once
+ * the values have been stable for SETTINGS_SAVE_DELAY ms.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/** Saved after being unchanged for this long (ms) */
+#define SETTINGS_SAVE_DELAY 3000
+
+/**
+ * Stored values. Bump SETTINGS_VERSION when the layout changes,
+ * records of other versions are ignored.
+ */
+#define SETTINGS_VERSION 2
+
+typedef struct {
+	float y_scale;
+	uint8_t brightness;
+	uint8_t render_mode;
+	uint8_t capture_preset; // sample rate & oversampling
+	uint8_t fft_size : 4; // index into the FFT configurations
+	uint8_t db_scale : 1; // spectrum on a dB scale
+	uint8_t : 3;
+} settings_t;
+
+/**
+ * @brief Find the latest valid record
+ * @param out : settings are written here if found
+ * @return true if found
+ */
+bool settings_load(settings_t *out);
+
+/**
+ * @brief Schedule a save; values are written after they've been stable for a while
+ * @param values : current settings
+ */
+void settings_changed(const settings_t *values);
+
+/** Write pending settings if they're due. Call from the main loop. */
+void settings_periodic(void);
+
+#endif // SETTINGS_H
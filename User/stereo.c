@@ -0,0 +1,76 @@
+#include <math.h>
+#include "stereo.h"
+#include "capture.h"
+
+
+void stereo_to_complex(uint32_t *buf, uint32_t count)
+{
+	float *out = (float *) buf;
+
+	if (count == 0) return;
+
+	uint32_t sum_l = 0, sum_r = 0;
+	for (uint32_t i = 0; i < count; i++) {
+		sum_l += SAMPLE_L(buf[i]);
+		sum_r += SAMPLE_R(buf[i]);
+	}
+
+	const float mean_l = (float) sum_l / count;
+	const float mean_r = (float) sum_r / count;
+
+	// backwards, so the output never overtakes unread input
+	for (int32_t i = count - 1; i >= 0; i--) {
+		const uint32_t w = buf[i];
+		out[i * 2] = SAMPLE_L(w) - mean_l;
+		out[i * 2 + 1] = SAMPLE_R(w) - mean_r;
+	}
+}
+
+
+void stereo_split_mag(const float *spectrum, uint32_t fft_len, float *mag_l, float *mag_r, uint32_t count)
+{
+	for (uint32_t k = 0; k < count; k++) {
+		const uint32_t n = (fft_len - k) & (fft_len - 1);
+
+		const float xr = spectrum[k * 2], xi = spectrum[k * 2 + 1];
+		const float yr = spectrum[n * 2], yi = spectrum[n * 2 + 1];
+
+		// L = (X + Y*) / 2, R = (X - Y*) / 2j
+		const float lr = xr + yr, li = xi - yi;
+		const float rr = xi + yi, ri = yr - xr;
+
+		mag_l[k] = 0.5f * sqrtf(lr * lr + li * li);
+		mag_r[k] = 0.5f * sqrtf(rr * rr + ri * ri);
+	}
+}
+
+
+float stereo_correlation(const uint32_t *samples, uint32_t count)
+{
+	if (count == 0) return 0;
+
+	uint32_t sum_l = 0, sum_r = 0;
+	for (uint32_t i = 0; i < count; i++) {
+		sum_l += SAMPLE_L(samples[i]);
+		sum_r += SAMPLE_R(samples[i]);
+	}
+
+	const int32_t mean_l = (int32_t) (sum_l / count);
+	const int32_t mean_r = (int32_t) (sum_r / count);
+
+	// 16-bit samples: the deviations reach +-65535 and their products overflow
+	// 32 bits, so multiply in 64 bits. The sums fit for any frame length.
+	int64_t lr = 0, ll = 0, rr = 0;
+	for (uint32_t i = 0; i < count; i++) {
+		const int32_t l = (int32_t) SAMPLE_L(samples[i]) - mean_l;
+		const int32_t r = (int32_t) SAMPLE_R(samples[i]) - mean_r;
+
+		lr += (int64_t) l * r;
+		ll += (int64_t) l * l;
+		rr += (int64_t) r * r;
+	}
+
+	if (ll == 0 || rr == 0) return 0;
+
+	return (float) lr / sqrtf((float) ll * (float) rr);
+}
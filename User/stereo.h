@@ -0,0 +1,45 @@
+#ifndef STEREO_H
+#define STEREO_H
+
+/**
+ * Stereo processing of the dual-ADC sample words (see capture.h).
+ *
+ * Both channels share one complex FFT: left goes in as the real part,
+ * right as the imaginary part, and the two spectra are separated using
+ * the conjugate symmetry of real signals:
+ *
+ *   L[k] = (X[k] + X*[N-k]) / 2
+ *   R[k] = (X[k] - X*[N-k]) / 2j
+ */
+
+#include <stdint.h>
+
+/**
+ * @brief Convert sample words to complex floats (L = real, R = imaginary), DC removed.
+ *
+ * Done in place; the buffer must have room for 2 * count floats.
+ *
+ * @param buf : sample words on input, complex floats on output
+ * @param count : number of sample words
+ */
+void stereo_to_complex(uint32_t *buf, uint32_t count);
+
+/**
+ * @brief Separate the packed spectrum into magnitudes of the two channels
+ * @param spectrum : complex FFT output in natural order
+ * @param fft_len : FFT length (complex points)
+ * @param mag_l : output, left magnitudes
+ * @param mag_r : output, right magnitudes
+ * @param count : number of bins to produce, at most fft_len / 2
+ */
+void stereo_split_mag(const float *spectrum, uint32_t fft_len, float *mag_l, float *mag_r, uint32_t count);
+
+/**
+ * @brief Correlation of the channels (Pearson coefficient)
+ * @param samples : sample words
+ * @param count : number of sample words
+ * @return -1 (out of phase) .. +1 (mono), 0 if a channel is silent
+ */
+float stereo_correlation(const uint32_t *samples, uint32_t count);
+
+#endif // STEREO_H
@@ -5,9 +5,16 @@
 
 register char *stack_ptr asm("sp");
 
+/**
+ * @brief Grow the heap. Only newlib uses it (stdio buffers),
+ * the application allocates from the static arena (arena.h).
+ *
+ * The heap is limited to _Min_Heap_Size from the linker script.
+ */
 caddr_t _sbrk(int incr)
 {
 	extern char end __asm("end");
+	extern char _heap_limit;
 	static char *heap_end;
 	char *prev_heap_end;
 
@@ -15,7 +22,7 @@ caddr_t _sbrk(int incr)
 		heap_end = &end;
 
 	prev_heap_end = heap_end;
-	if (heap_end + incr > stack_ptr) {
+	if (heap_end + incr > &_heap_limit || heap_end + incr > stack_ptr) {
 //		write(1, "Heap and stack collision\n", 25);
 //		abort();
 		errno = ENOMEM;
@@ -28,9 +35,47 @@ caddr_t _sbrk(int incr)
 }
 
 
+#ifdef SEMIHOSTING
+
+// ARM semihosting operations
+#define SYS_OPEN  0x01
+#define SYS_WRITE 0x05
+
+/** Semihosting call, handled by the debugger (or an emulator) at the breakpoint */
+static int semihost_call(int op, const void *args)
+{
+	register int r0 asm("r0") = op;
+	register const void *r1 asm("r1") = args;
+	__asm volatile ("bkpt 0xAB" : "+r" (r0) : "r" (r1) : "memory");
+	return r0;
+}
+
+/**
+ * @brief Write to the host console
+ * @return number of written bytes
+ */
+static int semihost_write(const char *buf, int len)
+{
+	static int tt = -1;
+
+	if (tt < 0) {
+		// ":tt" opened for writing is the host's stdout
+		const uint32_t open_args[3] = {(uint32_t) ":tt", 4, 3};
+		tt = semihost_call(SYS_OPEN, open_args);
+		if (tt < 0) return 0;
+	}
+
+	const uint32_t write_args[3] = {(uint32_t) tt, (uint32_t) buf, (uint32_t) len};
+	return len - semihost_call(SYS_WRITE, write_args); // returns the bytes not written
+}
+
+#endif
+
 /**
  * @brief Write to a file by file descriptor.
  *
+ * Goes to USART1, or to the debugger with SEMIHOSTING defined.
+ *
  * @param fd  : open file descriptor
  * @param buf : data to write
  * @param len : buffer size
@@ -41,8 +86,12 @@ int _write(int fd, const char *buf, int len)
 	switch (fd) {
 		case 1: // stdout
 		case 2: // stderr
+#ifdef SEMIHOSTING
+			return semihost_write(buf, len);
+#else
 			HAL_UART_Transmit(&huart1, (uint8_t*)buf, len, 10);
 			return len;
+#endif
 
 		default:
 			return 0;
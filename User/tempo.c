@@ -0,0 +1,172 @@
+#include <math.h>
+#include <stdbool.h>
+#include "tempo.h"
+
+/** Lags in slots; rounded down, so they cover the whole range: 16..50 (187..60 BPM) */
+#define LAG_MIN (60000 / (TEMPO_BPM_MAX * TEMPO_SLOT_MS))
+#define LAG_MAX (60000 / (TEMPO_BPM_MIN * TEMPO_SLOT_MS))
+#define LAG_COUNT (LAG_MAX - LAG_MIN + 1)
+
+/** Onset envelope history, power of 2 longer than LAG_MAX */
+#define HIST_LEN 64
+
+/** Preferred tempo and the width of the preference (octaves) */
+#define PRIOR_BPM 120.0f
+#define PRIOR_WIDTH 1.0f
+
+/** Needed ratio of the best lag's correlation to the envelope energy */
+#define MIN_CONFIDENCE 0.2f
+
+/** A gap this long (ms) restarts the slot timing instead of filling it */
+#define MAX_GAP 1000
+
+static float hist[HIST_LEN];
+static uint32_t hist_head = 0;
+
+static float acc[LAG_COUNT];
+static float weight[LAG_COUNT];
+static float energy = 0;
+static float decay = 0;
+
+static bool initialized = false;
+static ms_time_t slot_time = 0;
+static float slot_peak = 0;
+static float bpm = 0;
+
+
+/** Compute the constant tables */
+static void tempo_init(void)
+{
+	decay = expf(-(float) TEMPO_SLOT_MS / TEMPO_MEMORY_MS);
+
+	for (int i = 0; i < LAG_COUNT; i++) {
+		float lag_bpm = 60000.0f / ((LAG_MIN + i) * TEMPO_SLOT_MS);
+		float octaves = log2f(lag_bpm / PRIOR_BPM) / PRIOR_WIDTH;
+		weight[i] = expf(-0.5f * octaves * octaves);
+	}
+
+	initialized = true;
+}
+
+
+/** Add a slot to the envelope, update the correlations */
+static void push_slot(float x)
+{
+	hist_head = (hist_head + 1) & (HIST_LEN - 1);
+	hist[hist_head] = x;
+
+	energy = energy * decay + x * x;
+
+	for (int i = 0; i < LAG_COUNT; i++) {
+		const float past = hist[(hist_head - (LAG_MIN + i)) & (HIST_LEN - 1)];
+		acc[i] = acc[i] * decay + x * past;
+	}
+}
+
+
+/** Correlation at a fractional lag (slots), linearly interpolated; -1 out of range */
+static float acc_at(float lag)
+{
+	const float x = lag - LAG_MIN;
+	if (x < 0 || x > LAG_COUNT - 1) return -1;
+
+	const int i = (int) x;
+	if (i == LAG_COUNT - 1) return acc[i];
+
+	const float f = x - i;
+	return acc[i] * (1 - f) + acc[i + 1] * f;
+}
+
+
+/** Pick the best lag */
+static void estimate(void)
+{
+	float best_score = 0;
+	float best_peak = 0;
+	float best_lag = 0;
+
+	for (int i = 0; i < LAG_COUNT; i++) {
+		const float a = i > 0 ? acc[i - 1] : 0;
+		const float b = acc[i];
+		const float c = i < LAG_COUNT - 1 ? acc[i + 1] : 0;
+		if (b <= 0 || b < a || b < c) continue;
+
+		// interpolate the peak (parabola through the neighbours): a period
+		// between two lags splits its correlation between them, and would
+		// lose to one on a whole lag
+		float offset = 0;
+		float peak = b;
+		const float den = a - 2 * b + c;
+		if (i > 0 && i < LAG_COUNT - 1 && den < 0) {
+			offset = 0.5f * (a - c) / den;
+			peak = b - 0.25f * (a - c) * offset;
+		}
+		const float lag = LAG_MIN + i + offset;
+
+		// A beat correlates at twice its period too, a syncopation (a kick
+		// 1.5 beats after another) mostly doesn't. Score the peak with its
+		// octave partner, so both tempi of a pair score the same and the
+		// weights pick between them. Without one in range, count the peak twice.
+		float partner = acc_at(2 * lag);
+		if (partner < 0) partner = acc_at(lag / 2);
+		if (partner < 0) partner = peak;
+
+		const float score = (peak + partner) * weight[i];
+		if (score > best_score) {
+			best_score = score;
+			best_peak = peak;
+			best_lag = lag;
+		}
+	}
+
+	if (best_score <= 0 || best_peak < MIN_CONFIDENCE * energy) {
+		bpm = 0;
+		return;
+	}
+
+	bpm = 60000.0f / (best_lag * TEMPO_SLOT_MS);
+}
+
+
+void tempo_process(float strength, ms_time_t now)
+{
+	if (!initialized) tempo_init();
+
+	strength = sqrtf(strength);
+	if (strength > slot_peak) slot_peak = strength;
+
+	if (now - slot_time > MAX_GAP) {
+		slot_time = now;
+		return;
+	}
+
+	// a frame longer than a slot (256 points and up) covers the following
+	// slots too; leaving them empty would alias the beat against the slots
+	bool pushed = false;
+	while (now - slot_time >= TEMPO_SLOT_MS) {
+		push_slot(slot_peak);
+		slot_peak = strength;
+		slot_time += TEMPO_SLOT_MS;
+		pushed = true;
+	}
+
+	if (pushed) estimate();
+}
+
+
+void tempo_reset(void)
+{
+	for (int i = 0; i < HIST_LEN; i++) hist[i] = 0;
+	for (int i = 0; i < LAG_COUNT; i++) acc[i] = 0;
+	hist_head = 0;
+	energy = 0;
+	slot_time = 0;
+	slot_peak = 0;
+	bpm = 0;
+}
+
+
+float tempo_bpm(void)
+{
+	return bpm;
+}
@@ -0,0 +1,42 @@
+#ifndef TEMPO_H
+#define TEMPO_H
+
+/**
+ * Tempo (BPM) estimate from the onset strength, see onset.h.
+ *
+ * The strength is compressed (square root, so the timing of the hits counts
+ * more than their loudness) and resampled to fixed TEMPO_SLOT_MS slots, and
+ * each new slot updates a leaky autocorrelation over the lags of
+ * TEMPO_BPM_MIN..MAX. The cost is one multiply-add per lag and slot, with
+ * no periodic batch work. The correlation peaks are interpolated between
+ * the lags and scored together with the correlation at twice (or half)
+ * their lag; the best one, weighted towards common tempi, gives the BPM.
+ */
+
+#include <stdint.h>
+#include "timebase.h"
+
+/** Onset envelope sample period (ms) */
+#define TEMPO_SLOT_MS 20
+
+/** Tempo range */
+#define TEMPO_BPM_MIN 60
+#define TEMPO_BPM_MAX 180
+
+/** Memory of the autocorrelation, time constant (ms) */
+#define TEMPO_MEMORY_MS 4000
+
+/**
+ * @brief Feed the onset strength of a frame
+ * @param strength : onset strength
+ * @param now : frame timestamp (ms)
+ */
+void tempo_process(float strength, ms_time_t now);
+
+/** Forget the envelope and the estimate */
+void tempo_reset(void);
+
+/** Get the tempo estimate (BPM), 0 if there is no clear beat */
+float tempo_bpm(void);
+
+#endif // TEMPO_H
@@ -1,5 +1,5 @@
 #include "timebase.h"
-#include "malloc_safe.h"
+#include "arena.h"
 #include "debug.h"
 
 // Time base
@@ -51,8 +51,8 @@ void timebase_init(size_t periodic, size_t future)
 	periodic_slot_count = periodic;
 	future_slot_count = future;
 
-	periodic_tasks = calloc_s(periodic, sizeof(periodic_task_t));
-	future_tasks = calloc_s(future, sizeof(future_task_t));
+	periodic_tasks = arena_calloc(periodic, sizeof(periodic_task_t));
+	future_tasks = arena_calloc(future, sizeof(future_task_t));
 }
 
 
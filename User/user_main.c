@@ -3,26 +3,22 @@
 //
 
 #include <inttypes.h>
-#include <arm_math.h>
-#include <arm_const_structs.h>
+#include <string.h>
+#include <stdio.h>
 #include <stm32f1xx_hal_gpio.h>
 #include "dotmatrix.h"
-#include "adc.h"
-#include "tim.h"
 #include "user_main.h"
 #include "debounce.h"
 #include "debug.h"
-#include "fft_windows.h"
-
-// 512 = show 0-5 kHz
-// 256 = show 0-10 kHz
-// smaller range is OK since we have only a limited reception of higher frequencies anyway
-#define SAMPLE_COUNT 512
-#define BIN_COUNT (SAMPLE_COUNT/2)
-#define CFFT_INST arm_cfft_sR_f32_len256
-
-#define SCREEN_W 32
-#define SCREEN_H 16
+#include "arena.h"
+#include "meminfo.h"
+#include "settings.h"
+#include "osd.h"
+#include "capture.h"
+#include "fft_config.h"
+#include "pitch.h"
+#include "render.h"
+#include "bench.h"
 
 // Pins
 #define BTN_CENTER 0
@@ -31,262 +27,384 @@
 #define BTN_UP 3
 #define BTN_DOWN 4
 
-// Y axis scaling factors
-#define WAVEFORM_SCALE 0.007f
-#define FFT_SCALE 0.25f * 0.3f
-#define FFT_SPINDLE_SCALE_MULT 0.5f
+/** Interval of the frame rate log message (ms) */
+#define FPS_REPORT_INTERVAL 10000
 
-uint32_t audio_samples[SAMPLE_COUNT * 2]; // 2x size needed for complex FFT
-float *audio_samples_f = (float *) audio_samples;
+/**
+ * Interval of the frame dump (ms), 0 = disabled.
+ * Dumped frames are printed as plain PBM images, see dump_frame().
+ * The UART is slow, frequent dumps lower the frame rate.
+ */
+#define FRAME_DUMP_INTERVAL 0
 
-// counter for auto repeat
-ms_time_t updn_press_timer = 0;
-ms_time_t ltrt_press_timer = 0;
+// one word per sample pair (see capture.h), 2x size needed for complex FFT
+uint32_t audio_samples[FFT_MAX_LEN * 2];
 
 /** Dot matrix display instance */
 DotMatrix_Cfg *disp;
 
-/** Capture in progress flag */
-volatile bool capture_pending = false;
-
 /** scale & brightness config fields. Initial values. */
 float y_scale = 5;
 uint8_t brightness = 3;
 
+/**
+ * Set when the brightness changed, applied by finish_render().
+ * The display is only written from the render path (DMA interrupt),
+ * a transfer from the main loop could be interrupted mid-frame.
+ */
+static volatile bool brightness_changed = false;
+
+/** Capture presets, sample rate & oversampling, by rising rate */
+static const struct {
+	const char *name;
+	uint32_t rate;
+	uint8_t oversample;
+} capture_presets[] = {
+	{"8K", 8000, 1},
+	{"8K OS16", 8000, 16},
+	{"16K", 16000, 1},
+	{"16K OS16", 16000, 16},
+	{"20K", 20000, 1},
+	{"20K OS4", 20000, 4},
+	{"20K OS16", 20000, 16},
+	{"32K", 32000, 1},
+	{"32K OS8", 32000, 8},
+	{"44K", 44100, 1},
+	{"44K OS8", 44100, 8},
+};
+
+#define CAPTURE_PRESET_COUNT (sizeof(capture_presets) / sizeof(capture_presets[0]))
+#define CAPTURE_PRESET_DEFAULT 4 // 20 kHz
+
+/** Active capture preset */
+uint8_t capture_preset = CAPTURE_PRESET_DEFAULT;
+
+/**
+ * FFT size, see fft_config.h. The frame length is the same.
+ * The screen shows the first 32 bins, so a longer FFT zooms in on the bass:
+ * 256 = show 0-2.5 kHz at 20 kHz sample rate, 64 = the whole band.
+ */
+uint8_t fft_size = FFT_CONFIG_DEFAULT;
+
+/** FFT configuration of the frame being captured / processed */
+static const fft_config_t *frame_fft;
+
+/** Show the spectrum bars on a dB scale, otherwise linear */
+bool db_scale = false;
+
+/** Number of frames shown, for the frame rate */
+static volatile uint32_t frame_count = 0;
+
 /** active rendering mode (visualisation preset) */
-enum {
-	MODE_SPECTRUM,
-	MODE_SPECTRUM2,
-	MODE_WAVEFORM,
-	MAX_MODE
-} render_mode;
+render_mode_t render_mode;
+
+/** Mode names shown on the OSD */
+static const char *mode_names[RENDER_MODE_COUNT] = {
+	[RENDER_SPECTRUM] = "FFT",
+	[RENDER_SPINDLE] = "SPINDLE",
+	[RENDER_WAVEFORM] = "WAVE",
+	[RENDER_WATERFALL] = "WTRFALL",
+	[RENDER_VU] = "VU PPM",
+	[RENDER_STEREO] = "STEREO",
+	[RENDER_PHASE] = "PHASE",
+	[RENDER_BEAT] = "BEAT",
+	[RENDER_TUNER] = "TUNER",
+};
 
 bool up_pressed = false;
 bool down_pressed = false;
 bool left_pressed = false;
 bool right_pressed = false;
+bool center_pressed = false;
 
-static void display_wave();
-
-static void calculate_fft();
-
-static void display_fft();
-
-static void display_fft_spindle();
+/** An arrow was used together with the held center button, don't switch mode on release */
+bool center_chord = false;
 
 static void start_render();
 
+static void finish_render();
+
 // region Audio capture & display
 
-/** Start DMA to capture audio */
-void capture_start()
+/** Render the captured frame, called by the capture module in the DMA interrupt */
+void capture_complete_cb(void)
 {
-	if (capture_pending) return;
-	capture_pending = true;
-
-	//uart_print("- Starting ADC DMA\n");
-
-	HAL_ADC_Start_DMA(&hadc1, audio_samples, SAMPLE_COUNT);
-	HAL_TIM_Base_Start(&htim3);
+	const render_args_t args = {
+		.fft = frame_fft,
+		.sample_rate = capture_sample_rate(),
+		.time = capture_time(),
+		.y_scale = y_scale,
+		.db_scale = db_scale,
+	};
+
+	render_frame(render_mode, &args);
 }
 
-/** This callback is called by HAL after the transfer is complete */
-void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc)
-{
-	switch (render_mode) {
-		case MODE_WAVEFORM:
-			display_wave();
-			break;
-
-		case MODE_SPECTRUM:
-			calculate_fft();
-			display_fft();
-			break;
-
-		case MODE_SPECTRUM2:
-			calculate_fft();
-			display_fft_spindle();
-			break;
-	}
+// endregion
 
-	capture_pending = false;
-}
+// region UI
 
-/**
- * Convert audio samples to float.
- * NOTE: This trashes the original array of ints, they share the same memory location.
- */
-void samples_to_float()
+/** Clear screen & render "HUD" - button feedback lights */
+void start_render()
 {
-	// Convert to float
-	for (int i = 0; i < SAMPLE_COUNT; i++) {
-		audio_samples_f[i] = (float) audio_samples[i];
-	}
+	dmtx_clear(disp);
 
-	// Obtain mean value
-	float mean;
-	arm_mean_f32(audio_samples_f, SAMPLE_COUNT, &mean);
+	if (up_pressed) dmtx_set(disp, SCREEN_W - 2, SCREEN_H - 1, 1);
+	if (down_pressed) dmtx_set(disp, SCREEN_W - 2, SCREEN_H - 3, 1);
+	if (left_pressed) dmtx_set(disp, SCREEN_W - 3, SCREEN_H - 2, 1);
+	if (right_pressed) dmtx_set(disp, SCREEN_W - 1, SCREEN_H - 2, 1);
 
-	// Subtract mean from all samples
-	for (int i = 0; i < SAMPLE_COUNT; i++) {
-		audio_samples_f[i] -= mean;
-	}
+	// the middle of the joystick cross blinks with the beat
+	if (render_beat_flash(capture_time())) dmtx_set(disp, SCREEN_W - 2, SCREEN_H - 2, 1);
 }
 
-/** Spread numbers in the samples array so that they are interleaved by zeros (imaginary part) */
-void spread_samples_for_fft()
+/** Draw the OSD over the frame & show it */
+void finish_render()
 {
-	for (int i = SAMPLE_COUNT - 1; i >= 0; i--) {
-		audio_samples_f[i * 2 + 1] = 0;              // imaginary
-		audio_samples_f[i * 2] = audio_samples_f[i]; // * win_hamming_512[i]; // real
+	if (brightness_changed) {
+		brightness_changed = false;
+		dmtx_intensity(disp, brightness);
 	}
+
+	osd_render(disp);
+	dmtx_show(disp);
+	frame_count++;
 }
 
-/** Display waveform preview */
-void display_wave()
+/**
+ * Print the last shown frame as a plain PBM image (P1), top row first.
+ *
+ * The pixels are decoded from the display transmit buffer, so the dump
+ * covers the chain ordering too. The comment line makes it easy to cut
+ * the images out of a captured log and diff them against known frames.
+ */
+static void dump_frame(void)
 {
-	samples_to_float();
+	char line[SCREEN_W + 1];
 
-	int x_offset = 0;
+	dbg_printf("P1" DEBUG_EOL "# frame %"PRIu32" %s" DEBUG_EOL "%d %d" DEBUG_EOL,
+			   frame_count, mode_names[render_mode], SCREEN_W, SCREEN_H);
 
-	for (int i = 1; i < SAMPLE_COUNT; i++) {
-		if (audio_samples_f[i] > 0 && audio_samples_f[i - 1] < 0) {
-			x_offset = i;
-			break;
+	for (int32_t y = SCREEN_H - 1; y >= 0; y--) {
+		uint32_t row = dmtx_shown_row(disp, (uint32_t) y);
+		for (uint32_t x = 0; x < SCREEN_W; x++) {
+			line[x] = (char) ('0' + ((row >> x) & 1));
 		}
+		line[SCREEN_W] = 0;
+		dbg_raw(line);
+		dbg_raw(DEBUG_EOL);
 	}
+}
 
-	// make sure we're not gonna run out of range
-	if (x_offset >= SAMPLE_COUNT - SCREEN_W) {
-		x_offset = 0;
-	}
+/**
+ * Log the frame rate since the last report.
+ *
+ * Timed by the frame clock: the renders run at the SysTick priority and
+ * hold off ms_now(), which would make the interval look shorter.
+ */
+static void report_fps(void)
+{
+	static uint32_t last_count = 0;
+	static ms_time_t last_time = 0;
 
-	float totalmult = WAVEFORM_SCALE * y_scale;
+	const uint32_t count = frame_count;
+	const ms_time_t now = capture_time();
+	if (now == last_time) return;
 
-	start_render();
-	for (int i = 0; i < SCREEN_W; i++) {
-		dmtx_set(disp, i, 7 + roundf(audio_samples_f[i + x_offset] * totalmult), 1);
-	}
+	const uint32_t fps10 = (count - last_count) * 10000 / (now - last_time);
+	last_count = count;
+	last_time = now;
 
-	dmtx_show(disp);
+	info("%"PRIu32".%"PRIu32" fps", fps10 / 10, fps10 % 10);
 }
 
-/** Calculate and display FFT */
-static void calculate_fft()
+/** Show the scale on the OSD */
+static void osd_scale(void)
 {
-	float *bins = audio_samples_f;
-
-	samples_to_float();
-	spread_samples_for_fft();
-
-	const arm_cfft_instance_f32 *S;
-	S = &CFFT_INST;
+	char buf[OSD_MAX_LEN + 1];
+	snprintf(buf, sizeof(buf), "SC %.1f", y_scale);
+	osd_show(buf, OSD_DURATION);
+}
 
-	arm_cfft_f32(S, bins, 0, true); // bit reversed FFT
-	arm_cmplx_mag_f32(bins, bins, BIN_COUNT); // get magnitude (extract real values)
+/** Show the brightness on the OSD */
+static void osd_brightness(void)
+{
+	char buf[OSD_MAX_LEN + 1];
+	snprintf(buf, sizeof(buf), "BR %d", brightness);
+	osd_show(buf, OSD_DURATION);
+}
 
-	// Normalize & display
+/** Schedule saving of the user settings to Flash */
+static void save_settings(void)
+{
+	settings_t stored;
+	memset(&stored, 0, sizeof(stored));
 
-	start_render();
+	stored.y_scale = y_scale;
+	stored.brightness = brightness;
+	stored.render_mode = render_mode;
+	stored.capture_preset = capture_preset;
+	stored.fft_size = fft_size;
+	stored.db_scale = db_scale;
 
-	float factor = (1.0f / BIN_COUNT) * FFT_SCALE * y_scale;
-	for (int i = 0; i < BIN_COUNT; i++) { // +1 because bin 0 is always 0
-		bins[i] *= factor;
-	}
+	settings_changed(&stored);
 }
 
-/** Render classic FFT */
-static void display_fft()
+/** Apply settings stored in Flash, if any */
+static void load_settings(void)
 {
-	float *bins = audio_samples_f;
+	settings_t stored;
 
-	for (int x = 0; x < SCREEN_W; x++) {
-		for (int j = 0; j < 1 + floorf(bins[x]); j++) {
-			dmtx_set(disp, x, j, 1);
-		}
+	if (!settings_load(&stored)) {
+		info("No stored settings, using defaults");
+		return;
 	}
 
-	dmtx_show(disp);
+	if (stored.y_scale >= 0.5f && stored.y_scale <= 100) y_scale = stored.y_scale;
+	if (stored.brightness <= 15) brightness = stored.brightness;
+	if (stored.render_mode < RENDER_MODE_COUNT) render_mode = stored.render_mode;
+	if (stored.capture_preset < CAPTURE_PRESET_COUNT) capture_preset = stored.capture_preset;
+	if (stored.fft_size < FFT_CONFIG_COUNT) fft_size = stored.fft_size;
+	db_scale = stored.db_scale;
 }
 
-/** Render FFT "spindle" */
-static void display_fft_spindle()
+/** Apply the capture preset */
+static void apply_capture_preset(void)
 {
-	float *bins = audio_samples_f;
+	capture_set_rate(capture_presets[capture_preset].rate, capture_presets[capture_preset].oversample);
+}
 
-	for (int x = 0; x < SCREEN_W; x++) {
-		for (int j = 0; j < 1 + floorf(bins[x] * FFT_SPINDLE_SCALE_MULT); j++) {
-			dmtx_set(disp, x, 7 + j, 1);
-			dmtx_set(disp, x, 7 - j, 1);
-		}
+/** Step to the next / previous capture preset */
+static void step_capture_preset(bool up)
+{
+	if (up) {
+		if (capture_preset < CAPTURE_PRESET_COUNT - 1) capture_preset++;
+	} else {
+		if (capture_preset > 0) capture_preset--;
 	}
 
-	dmtx_show(disp);
-}
-
-// endregion
+	apply_capture_preset();
 
-// region UI
+	info("Capture preset %s", capture_presets[capture_preset].name);
+	osd_show(capture_presets[capture_preset].name, OSD_DURATION);
+	save_settings();
+}
 
-/** Clear screen & render "HUD" - button feedback lights */
-void start_render()
+/** Step to a longer / shorter FFT, applied with the next capture */
+static void step_fft_size(bool up)
 {
-	dmtx_clear(disp);
+	if (up) {
+		if (fft_size < FFT_CONFIG_COUNT - 1) fft_size++;
+	} else {
+		if (fft_size > 0) fft_size--;
+	}
 
-	if (up_pressed) dmtx_set(disp, SCREEN_W - 2, SCREEN_H - 1, 1);
-	if (down_pressed) dmtx_set(disp, SCREEN_W - 2, SCREEN_H - 3, 1);
-	if (left_pressed) dmtx_set(disp, SCREEN_W - 3, SCREEN_H - 2, 1);
-	if (right_pressed) dmtx_set(disp, SCREEN_W - 1, SCREEN_H - 2, 1);
+	info("FFT size %d", fft_config_get(fft_size)->fft_len);
+	osd_show(fft_config_get(fft_size)->name, OSD_DURATION);
+	save_settings();
 }
 
-/** Callback when button press state changes */
-static void gamepad_button_cb(uint32_t btn, bool press)
+/** Callback when a button event is dispatched (runs in the main loop) */
+static void gamepad_button_cb(uint32_t btn, debo_event_t ev)
 {
-	dbg("Button press %d, state %d", btn, press);
+	bool press = (ev == DEBO_EV_PRESS);
+	bool adjust = (ev == DEBO_EV_PRESS || ev == DEBO_EV_REPEAT);
+
+	dbg("Button %d, event %d", btn, ev);
 
 	switch (btn) {
 		case BTN_UP:
-			up_pressed = press;
-			if (press) {
-				updn_press_timer = 0;
+			if (ev == DEBO_EV_PRESS || ev == DEBO_EV_RELEASE) up_pressed = press;
+			if (center_pressed) {
+				// center + up: next capture preset
+				if (adjust) {
+					center_chord = true;
+					step_capture_preset(true);
+				}
+			} else if (adjust) {
 				y_scale += 0.5f;
+				dbg("scale = %.1f", y_scale);
+				osd_scale();
+				save_settings();
 			}
 			break;
 
 		case BTN_DOWN:
-			down_pressed = press;
-			if (press) {
-				updn_press_timer = 0;
+			if (ev == DEBO_EV_PRESS || ev == DEBO_EV_RELEASE) down_pressed = press;
+			if (center_pressed) {
+				// center + down: previous capture preset
+				if (adjust) {
+					center_chord = true;
+					step_capture_preset(false);
+				}
+			} else if (adjust) {
 				if (y_scale > 0.55) y_scale -= 0.5f;
+				dbg("scale = %.1f", y_scale);
+				osd_scale();
+				save_settings();
 			}
 			break;
 
 		case BTN_LEFT:
-			left_pressed = press;
-			if (press) {
-				ltrt_press_timer = 0;
+			if (ev == DEBO_EV_PRESS || ev == DEBO_EV_RELEASE) left_pressed = press;
+			if (center_pressed) {
+				// center + left: shorter FFT
+				if (adjust) {
+					center_chord = true;
+					step_fft_size(false);
+				}
+			} else if (adjust) {
 				if (brightness > 0) brightness--;
+				brightness_changed = true;
+				osd_brightness();
+				save_settings();
 			}
 			break;
 
 		case BTN_RIGHT:
-			right_pressed = press;
-			if (press) {
-				ltrt_press_timer = 0;
+			if (ev == DEBO_EV_PRESS || ev == DEBO_EV_RELEASE) right_pressed = press;
+			if (center_pressed) {
+				// center + right: longer FFT
+				if (adjust) {
+					center_chord = true;
+					step_fft_size(true);
+				}
+			} else if (adjust) {
 				if (brightness < 15) brightness++;
+				brightness_changed = true;
+				osd_brightness();
+				save_settings();
 			}
 			break;
 
 		case BTN_CENTER:
-			if (!press) {
+			if (ev == DEBO_EV_PRESS) {
+				center_pressed = true;
+				center_chord = false;
+			}
+
+			if (ev == DEBO_EV_LONG) {
+				// long press: linear / dB scale
+				center_chord = true;
+				db_scale = !db_scale;
+				osd_show(db_scale ? "DB" : "LIN", OSD_DURATION);
+				save_settings();
+			}
+
+			if (ev == DEBO_EV_RELEASE) {
+				center_pressed = false;
+				if (center_chord) break; // used as a modifier
+
 				// center button released
 				// cycle through modes
-				if (++render_mode == MAX_MODE) {
+				if (++render_mode == RENDER_MODE_COUNT) {
 					render_mode = 0;
 				}
-			}
 
-			info("Switched to render mode %d", render_mode);
+				info("Switched to render mode %d", render_mode);
+				osd_show(mode_names[render_mode], OSD_DURATION);
+				save_settings();
+			}
 			break;
 	}
 }
@@ -308,6 +426,12 @@ void user_init()
 	// Enable audio input
 	HAL_GPIO_WritePin(AUDIO_NSTBY_GPIO_Port, AUDIO_NSTBY_Pin, 1);
 
+	load_settings();
+
+	// the rate dependent tables are set up with the first frame
+	apply_capture_preset();
+	capture_init();
+
 	// Init display
 	DotMatrix_Init disp_init;
 	disp_init.cols = 4;
@@ -322,20 +446,38 @@ void user_init()
 	dmtx_clear(disp);
 	dmtx_show(disp);
 
+	render_init_t render_cfg;
+	render_cfg.disp = disp;
+	render_cfg.samples = audio_samples;
+	render_cfg.start = start_render;
+	render_cfg.finish = finish_render;
+	render_init(&render_cfg);
+
 	timebase_init(5, 5);
+#ifdef BENCHMARK
+	debounce_init(5 + BENCH_DEBO_PINS); // bench_run() adds its pins
+#else
 	debounce_init(5);
+#endif
+	pitch_init();
 
 	// Gamepad
 	debo_init_t debo;
 	debo.debo_time = 50;
 	debo.invert = true;
 	debo.callback = gamepad_button_cb;
+	debo.repeat_delay = 0;
+	debo.repeat_interval = 0;
 	// Central button
+	debo.long_time = 800; // toggles the dB scale
 	debo.cb_payload = BTN_CENTER;
 	debo.GPIOx = BTN_CE_GPIO_Port;
 	debo.pin = BTN_CE_Pin;
 	debo_register_pin(&debo);
+	debo.long_time = 0;
 	// Left
+	debo.repeat_delay = 400; // hold-to-repeat
+	debo.repeat_interval = 250;
 	debo.cb_payload = BTN_LEFT;
 	debo.GPIOx = BTN_L_GPIO_Port;
 	debo.pin = BTN_L_Pin;
@@ -346,6 +488,8 @@ void user_init()
 	debo.pin = BTN_R_Pin;
 	debo_register_pin(&debo);
 	// Up
+	debo.repeat_delay = 300;
+	debo.repeat_interval = 100;
 	debo.cb_payload = BTN_UP;
 	debo.GPIOx = BTN_UP_GPIO_Port;
 	debo.pin = BTN_UP_Pin;
@@ -355,61 +499,66 @@ void user_init()
 	debo.GPIOx = BTN_DN_GPIO_Port;
 	debo.pin = BTN_DN_Pin;
 	debo_register_pin(&debo);
+
+	// no more allocations past this point
+	arena_seal();
 }
 
 /** Main function, called from MX-generated main.c */
 void user_main()
 {
+	meminfo_paint_stack();
+
 	banner("== USER CODE STARTING ==");
 
 	user_init();
+	meminfo_report();
+
+#ifdef BENCHMARK
+	bench_run(disp, audio_samples);
+	while (1);
+#endif
 
 	ms_time_t counter1 = 0;
+	ms_time_t counter_mem = 0;
+	ms_time_t counter_fps = 0;
+	ms_time_t counter_dump = 0;
+	bool dump_due = false;
 	while (1) {
 		if (ms_loop_elapsed(&counter1, 500)) {
 			// Blink
 			HAL_GPIO_TogglePin(LED1_GPIO_Port, LED1_Pin);
 		}
 
-		// hold-to-repeat
-		// This is not the correct way to do it, but good enough
-		if (ms_loop_elapsed(&updn_press_timer, 100)) {
-			if (up_pressed) {
-				y_scale += 0.5;
-			}
+		if (ms_loop_elapsed(&counter_mem, 30000)) {
+			meminfo_report();
+		}
 
-			if (down_pressed) {
-				if (y_scale > 0.55) {
-					y_scale -= 0.5;
-				}
-			}
+		if (ms_loop_elapsed(&counter_fps, FPS_REPORT_INTERVAL)) {
+			report_fps();
+		}
 
-			if (up_pressed || down_pressed) {
-				dbg("scale = %.1f", y_scale);
-			}
+		if (FRAME_DUMP_INTERVAL && ms_loop_elapsed(&counter_dump, FRAME_DUMP_INTERVAL)) {
+			dump_due = true;
 		}
 
-		if (ms_loop_elapsed(&ltrt_press_timer, 250)) {
-			if (left_pressed) {
-				if (brightness > 0) {
-					brightness--;
-				}
-			}
+		// button callbacks, including hold-to-repeat
+		debo_process_events();
 
-			if (right_pressed) {
-				if (brightness < 15) {
-					brightness++;
-				}
-			}
+		// write changed settings to Flash when due
+		settings_periodic();
 
-			if (left_pressed || right_pressed) {
-				dmtx_intensity(disp, brightness);
+		// capture a sample to update display
+		if (!capture_busy()) {
+			// the frame is complete and stays put until the next capture
+			if (dump_due && frame_count > 0) {
+				dump_frame();
+				dump_due = false;
 			}
-		}
 
-		// capture a sample to update display
-		if (!capture_pending) {
-			capture_start();
+			// the tuner needs the longest frame to reach low notes
+			frame_fft = fft_config_get(render_mode == RENDER_TUNER ? FFT_CONFIG_COUNT - 1 : fft_size);
+			capture_start(audio_samples, frame_fft->fft_len);
 		}
 	}
 }
@@ -0,0 +1,128 @@
+#include <math.h>
+#include <stdbool.h>
+#include "vu_meter.h"
+#include "capture.h"
+
+/** Full scale amplitude (16-bit samples, AC coupled) */
+#define FULL_SCALE 32768
+
+/** Fractional bits of the gain */
+#define Q 8
+
+// Row thresholds: row r is lit when the level reaches threshold r
+static uint32_t th_mean_square[VU_ROWS];
+static uint32_t th_amplitude[VU_ROWS];
+
+// Ballistics coefficients, Q16
+static uint32_t vu_coef;   // one-pole smoothing of the mean square
+static uint32_t ppm_decay; // multiplier per frame
+static uint32_t hold_frames;
+
+// Meter state
+static uint32_t vu_ms = 0;
+static uint32_t ppm = 0;
+static uint32_t ppm_hold = 0;
+static uint32_t hold_counter = 0;
+
+
+void vu_configure(float sample_rate, uint32_t frame_len)
+{
+	const float frame_s = frame_len / sample_rate;
+
+	for (int r = 0; r < VU_ROWS; r++) {
+		float db = (float) ((r + 1 - VU_ROWS) * VU_DB_PER_ROW);
+		float amp = FULL_SCALE * powf(10.0f, db / 20.0f);
+
+		th_amplitude[r] = (uint32_t) amp;
+		th_mean_square[r] = (uint32_t) (amp * amp);
+	}
+
+	// VU: 99 % in 300 ms -> tau = 300 ms / ln(100)
+	const float vu_tau = 0.3f / 4.605f;
+	vu_coef = (uint32_t) ((1.0f - expf(-frame_s / vu_tau)) * 65536);
+
+	// PPM: -20 dB in 1.7 s
+	ppm_decay = (uint32_t) (powf(10.0f, -1.0f * frame_s / 1.7f) * 65536);
+
+	hold_frames = (uint32_t) (VU_PEAK_HOLD_MS / 1000.0f / frame_s);
+}
+
+
+void vu_process(const uint32_t *samples, uint32_t count, float gain)
+{
+	if (count == 0) return;
+
+	// DC offset
+	uint32_t sum = 0;
+	for (uint32_t i = 0; i < count; i++) {
+		sum += SAMPLE_L(samples[i]);
+	}
+	const int32_t mean = (int32_t) (sum / count);
+
+	// energy and peak
+	uint64_t sum_sq = 0;
+	uint32_t peak = 0;
+	for (uint32_t i = 0; i < count; i++) {
+		int32_t s = (int32_t) SAMPLE_L(samples[i]) - mean;
+		sum_sq += (uint64_t) ((int64_t) s * s); // s*s reaches 2^32
+
+		uint32_t a = (uint32_t) (s < 0 ? -s : s);
+		if (a > peak) peak = a;
+	}
+
+	const uint64_t g = (uint64_t) (gain * (1 << Q));
+
+	// mean square and peak with gain
+	uint64_t ms64 = ((sum_sq / count) * g * g) >> (2 * Q);
+	uint32_t ms = (ms64 > UINT32_MAX) ? UINT32_MAX : (uint32_t) ms64;
+	uint64_t peak64 = ((uint64_t) peak * g) >> Q;
+	peak = (peak64 > UINT32_MAX) ? UINT32_MAX : (uint32_t) peak64;
+
+	// VU - one-pole smoothing
+	int64_t diff = (int64_t) ms - vu_ms;
+	vu_ms = (uint32_t) (vu_ms + ((diff * vu_coef) >> 16));
+
+	// PPM - instant attack, exponential fall
+	if (peak > ppm) {
+		ppm = peak;
+	} else {
+		ppm = (uint32_t) (((uint64_t) ppm * ppm_decay) >> 16);
+	}
+
+	// peak hold
+	if (ppm >= ppm_hold) {
+		ppm_hold = ppm;
+		hold_counter = hold_frames;
+	} else if (hold_counter > 0) {
+		hold_counter--;
+	} else {
+		ppm_hold = ppm;
+	}
+}
+
+
+/** Count rows whose threshold the value reaches */
+static uint32_t height(const uint32_t *thresholds, uint32_t value)
+{
+	uint32_t h = 0;
+	while (h < VU_ROWS && value >= thresholds[h]) h++;
+	return h;
+}
+
+
+uint32_t vu_rms_height(void)
+{
+	return height(th_mean_square, vu_ms);
+}
+
+
+uint32_t vu_peak_height(void)
+{
+	return height(th_amplitude, ppm);
+}
+
+
+uint32_t vu_hold_height(void)
+{
+	return height(th_amplitude, ppm_hold);
+}
@@ -0,0 +1,45 @@
+#ifndef VU_METER_H
+#define VU_METER_H
+
+/**
+ * Level meter working on the captured 16-bit samples with integer maths.
+ *
+ * VU: RMS with a ~300 ms integration time (99 % rise).
+ * PPM: true peak, instant attack, 20 dB fall in 1.7 s (IEC 60268-10 type I), with peak hold.
+ *
+ * Levels are shown on a dB scale, VU_DB_PER_ROW per row, the top row is 0 dBFS.
+ */
+
+#include <stdint.h>
+
+#define VU_ROWS 16
+#define VU_DB_PER_ROW 3
+
+/** Peak hold time (ms) */
+#define VU_PEAK_HOLD_MS 1000
+
+/**
+ * @brief Set up ballistics for the frame period
+ * @param sample_rate : sample rate (Hz)
+ * @param frame_len : samples per frame
+ */
+void vu_configure(float sample_rate, uint32_t frame_len);
+
+/**
+ * @brief Process a frame
+ * @param samples : sample words, the left channel is used
+ * @param count : number of samples
+ * @param gain : input gain (1 = no change)
+ */
+void vu_process(const uint32_t *samples, uint32_t count, float gain);
+
+/** Get the VU (RMS) bar height, 0..VU_ROWS */
+uint32_t vu_rms_height(void);
+
+/** Get the PPM bar height, 0..VU_ROWS */
+uint32_t vu_peak_height(void);
+
+/** Get the PPM peak hold height, 0..VU_ROWS */
+uint32_t vu_hold_height(void);
+
+#endif // VU_METER_H
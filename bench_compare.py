@@ -0,0 +1,75 @@
+#!/usr/bin/env python3
+"""
+Compare two benchmark runs (User/bench.h), e.g. before and after a change.
+
+Usage:
+  bench_compare.py before.log after.log [--metric cycles_min]
+
+The logs are captured debug output; the JSON lines are picked out of them
+(colour codes and other output around them are skipped). Cases are matched
+by name and "n". Prints both values per case and the speedup (before / after).
+"""
+
+import argparse
+import json
+import sys
+
+
+def parse_log(filename):
+    """ Benchmark results of a log; returns {(bench, n): result} in log order """
+    results = {}
+
+    with open(filename, errors='replace') as f:
+        for line in f:
+            start = line.find('{"bench"')
+            if start < 0:
+                continue
+            try:
+                r = json.loads(line[start:].strip())
+            except ValueError:
+                continue
+            results[(r['bench'], r.get('n', 0))] = r
+
+    return results
+
+
+def compare(before, after, metric):
+    """ Rows of (bench, n, before, after, speedup); cases missing in a run have None """
+    rows = []
+    keys = list(before) + [k for k in after if k not in before]
+
+    for key in keys:
+        b = before.get(key, {}).get(metric)
+        a = after.get(key, {}).get(metric)
+        speedup = b / a if a and b is not None else None
+        rows.append((key[0], key[1], b, a, speedup))
+
+    return rows
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Compare two benchmark logs')
+    parser.add_argument('before')
+    parser.add_argument('after')
+    parser.add_argument('--metric', default='cycles_mean', help='result field to compare (default cycles_mean)')
+    args = parser.parse_args()
+
+    before = parse_log(args.before)
+    after = parse_log(args.after)
+    if not before or not after:
+        print('error: no benchmark results in %s' % (args.before if not before else args.after), file=sys.stderr)
+        return 1
+
+    print('%-24s %6s %12s %12s %8s' % ('Case', 'n', 'Before', 'After', 'Speedup'))
+    print('-' * 66)
+    for bench, n, b, a, speedup in compare(before, after, args.metric):
+        print('%-24s %6d %12s %12s %8s' % (bench, n,
+                                           '-' if b is None else b,
+                                           '-' if a is None else a,
+                                           '-' if speedup is None else '%.2fx' % speedup))
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,262 @@
+#!/usr/bin/env python3
+"""
+Per-module RAM / Flash usage table from the GNU ld map file.
+
+Usage:
+  map_report.py binary.map                     print the table and the code run from RAM
+  map_report.py binary.map --save budget.txt   record the current sizes as the baseline
+  map_report.py binary.map --check budget.txt  fail if a module grew over the baseline
+  map_report.py binary.map --ram-objects arm_cfft_f32.c ...
+                                               fail if the code of an object isn't all in .data
+
+A missing baseline is a warning, or an error with --require-baseline.
+
+Modules are source files for our own objects and archives for libraries
+(libHAL.a, libCMSIS.a, libc.a...).
+
+Code placed in .data (RAMFUNC functions, the CMSIS-DSP and libgcc objects
+the linker script moves there) is listed separately: it is the RAM cost
+of running it from SRAM, part of each module's RAM column. The objects
+are picked by file name patterns in the linker script; one that doesn't
+match leaves the code in flash without a word, --ram-objects catches it.
+"""
+
+import argparse
+import os
+import re
+import sys
+
+# output sections -> (counts to flash, counts to RAM)
+SECTIONS = {
+    '.isr_vector': (True, False),
+    '.text': (True, False),
+    '.rodata': (True, False),
+    '.ARM.extab': (True, False),
+    '.ARM': (True, False),
+    '.preinit_array': (True, False),
+    '.init_array': (True, False),
+    '.fini_array': (True, False),
+    '.data': (True, True),
+    '.bss': (False, True),
+}
+
+RE_OUT_SECTION = re.compile(r'^(\.[\w.]+)')
+RE_IN_SECTION = re.compile(r'^ (\S+)\s*$|^ (\S+)\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)\s+(.+)$')
+RE_CONTINUATION = re.compile(r'^\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)\s+(.+)$')
+
+
+def module_name(path):
+    """ Make a short module name from an object file path """
+    m = re.match(r'(.*\.a)\((.*)\)$', path)
+    if m:
+        return os.path.basename(m.group(1))
+
+    name = os.path.basename(path)
+    return re.sub(r'\.obj$|\.o$', '', name)
+
+
+def object_name(path):
+    """ The object file name of a path, without the archive and .o / .obj """
+    m = re.match(r'.*\((.*)\)$', path)
+    name = m.group(1) if m else os.path.basename(path)
+    return re.sub(r'\.obj$|\.o$', '', name)
+
+
+def input_sections(filename):
+    """ Yield (output section, input section, size, object) for the counted output sections """
+    out_section = None
+    pending = None
+    in_map = False
+
+    with open(filename) as f:
+        for line in f:
+            line = line.rstrip('\n')
+
+            if not in_map:
+                in_map = line.startswith('Linker script and memory map')
+                continue
+
+            m = RE_OUT_SECTION.match(line)
+            if m:
+                out_section = m.group(1)
+                pending = None
+                continue
+
+            if out_section not in SECTIONS:
+                continue
+
+            size = None
+            obj = None
+            name = None
+
+            m = RE_IN_SECTION.match(line)
+            if m and m.group(1) and not m.group(1).startswith('*'):
+                # long section name, the rest is on the next line
+                pending = m.group(1)
+                continue
+            elif m and m.group(2) and not m.group(2).startswith('*'):
+                name, size, obj = m.group(2), int(m.group(4), 16), m.group(5)
+            elif pending:
+                m = RE_CONTINUATION.match(line)
+                if m:
+                    name, size, obj = pending, int(m.group(2), 16), m.group(3)
+
+            pending = None
+
+            if not size or obj is None:
+                continue
+
+            yield out_section, name, size, obj.strip()
+
+
+def parse_map(filename):
+    """ Sum input section sizes per module; returns {module: [flash, ram]} """
+    modules = {}
+
+    for out_section, _, size, obj in input_sections(filename):
+        flash, ram = SECTIONS[out_section]
+        entry = modules.setdefault(module_name(obj), [0, 0])
+        if flash:
+            entry[0] += size
+        if ram:
+            entry[1] += size
+
+    return modules
+
+
+def parse_ram_code(filename):
+    """ Sum the code in .data per module; returns {module: bytes} """
+    code = {}
+
+    for out_section, name, size, obj in input_sections(filename):
+        if out_section == '.data' and (name.startswith('.ramfunc') or name.startswith('.text')):
+            module = module_name(obj)
+            code[module] = code.get(module, 0) + size
+
+    return code
+
+
+def check_ram_objects(filename, names):
+    """ Check that the code of the objects is linked, in .data only; return list of error messages """
+    placed = {}
+    for out_section, name, _, obj in input_sections(filename):
+        if name.startswith('.text'):
+            placed.setdefault(object_name(obj), set()).add(out_section)
+
+    errors = []
+    for name in names:
+        sections = placed.get(name, set())
+        if '.text' in sections:
+            errors.append('%s: code in flash (.text), not matched by the linker script' % name)
+        elif '.data' not in sections:
+            errors.append('%s: no code in .data, the object is not linked' % name)
+    return errors
+
+
+def print_table(modules):
+    print('%-36s %8s %8s' % ('Module', 'Flash', 'RAM'))
+    print('-' * 54)
+
+    total = [0, 0]
+    for name, (flash, ram) in sorted(modules.items(), key=lambda kv: -(kv[1][0] + kv[1][1])):
+        print('%-36s %8d %8d' % (name, flash, ram))
+        total[0] += flash
+        total[1] += ram
+
+    print('-' * 54)
+    print('%-36s %8d %8d' % ('Total', total[0], total[1]))
+
+
+def print_ram_code(code):
+    if not code:
+        return
+
+    print()
+    print('%-36s %8s' % ('Code run from RAM (in .data)', 'Bytes'))
+    print('-' * 45)
+    for name, size in sorted(code.items(), key=lambda kv: -kv[1]):
+        print('%-36s %8d' % (name, size))
+    print('-' * 45)
+    print('%-36s %8d' % ('Total', sum(code.values())))
+
+
+def load_budget(filename):
+    budget = {}
+    with open(filename) as f:
+        for line in f:
+            line = line.split('#')[0].strip()
+            if not line:
+                continue
+            name, flash, ram = line.split()
+            budget[name] = (int(flash), int(ram))
+    return budget
+
+
+def save_budget(filename, modules):
+    with open(filename, 'w') as f:
+        f.write('# module flash ram - generated by map_report.py --save\n')
+        for name, (flash, ram) in sorted(modules.items()):
+            f.write('%s %d %d\n' % (name, flash, ram))
+
+
+def check_budget(modules, budget, margin):
+    """ Compare with the baseline, return list of error messages """
+    errors = []
+    for name, (flash, ram) in sorted(modules.items()):
+        if name not in budget:
+            print('warning: %s is not in the baseline (%d flash, %d RAM)' % (name, flash, ram), file=sys.stderr)
+            continue
+
+        for label, now, base in (('flash', flash, budget[name][0]), ('RAM', ram, budget[name][1])):
+            limit = base + max(base * margin / 100.0, 64)
+            if now > limit:
+                errors.append('%s: %s grew from %d to %d bytes (limit %d)' % (name, label, base, now, limit))
+    return errors
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Per-module RAM/Flash usage from a GNU ld map file')
+    parser.add_argument('mapfile')
+    parser.add_argument('--save', metavar='BUDGET', help='store current sizes as the baseline')
+    parser.add_argument('--check', metavar='BUDGET', help='fail if a module grew beyond the baseline')
+    parser.add_argument('--margin', type=float, default=10, help='allowed growth in %% (default 10)')
+    parser.add_argument('--require-baseline', action='store_true', help='fail if the baseline file is missing')
+    parser.add_argument('--ram-objects', metavar='OBJECT', nargs='+', default=[],
+                        help='objects (file name without .o) whose code must be in .data')
+    args = parser.parse_args()
+
+    modules = parse_map(args.mapfile)
+    print_table(modules)
+    print_ram_code(parse_ram_code(args.mapfile))
+
+    errors = check_ram_objects(args.mapfile, args.ram_objects)
+    for e in errors:
+        print('error: %s' % e, file=sys.stderr)
+    if errors:
+        return 1
+
+    if args.save:
+        save_budget(args.save, modules)
+        print('Baseline saved to %s' % args.save)
+
+    if args.check:
+        if not os.path.exists(args.check):
+            if args.require_baseline:
+                print('error: no baseline in %s; run "make mem_baseline" and commit it' % args.check,
+                      file=sys.stderr)
+                return 1
+            print('warning: no baseline in %s, size check skipped; run "make mem_baseline" to create it'
+                  % args.check, file=sys.stderr)
+            return 0
+
+        errors = check_budget(modules, load_budget(args.check), args.margin)
+        for e in errors:
+            print('error: %s' % e, file=sys.stderr)
+        if errors:
+            return 1
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,94 @@
+#include <inttypes.h>
+#include <string.h>
+#include "stm32f1xx_hal.h"
+#include "arena.h"
+#include "debug.h"
+#include "timebase.h"
+#include "debounce.h"
+#include "dotmatrix.h"
+#include "fft_config.h"
+#include "pitch.h"
+#include "user_main.h"
+#include "bench.h"
+
+// The firmware benchmark (User/bench.c) on QEMU's mps2-an385, a Cortex-M3 board.
+//
+// The cases that don't need the chip, set up like test/bench_host.c: the
+// display on registers in RAM, the SPI is the null one.
+// The output goes to the QEMU console over semihosting, the run ends with
+// a semihosting exit, so QEMU quits. Run it with the qemu_bench target:
+//
+//   qemu-system-arm -M mps2-an385 -nographic -semihosting -icount shift=0 -kernel f107-fft-qemu.elf
+//
+// With -icount shift=0 an instruction takes 1 ns of virtual time, SysTick
+// counts that time at SystemCoreClock: ns_mean is the instruction count of
+// a call (in steps of 40, one SysTick tick at 25 MHz). No wait states, no
+// bus contention: the chip takes longer, this is the M3 code cost.
+
+// semihosting exit (SYS_EXIT) and its reasons; QEMU exits with 0 or 1
+#define SYS_EXIT 0x18
+#define ADP_STOPPED_APPLICATION_EXIT 0x20026
+#define ADP_STOPPED_RUNTIME_ERROR 0x20023
+
+/** The mps2-an385 FPGA image clocks the M3 at 25 MHz */
+uint32_t SystemCoreClock = 25000000;
+
+static uint32_t buf[FFT_MAX_LEN * 2];
+
+static SPI_TypeDef spi = {.SR = SPI_SR_TXE};
+static GPIO_TypeDef port;
+
+static void qemu_exit(bool ok)
+{
+	register int r0 asm("r0") = SYS_EXIT;
+	register int r1 asm("r1") = ok ? ADP_STOPPED_APPLICATION_EXIT : ADP_STOPPED_RUNTIME_ERROR;
+	__asm volatile ("bkpt 0xAB" : "+r" (r0) : "r" (r1) : "memory");
+	while (1);
+}
+
+void Default_Handler(void)
+{
+	error("Fault or unexpected interrupt, IPSR %"PRIu32, __get_IPSR());
+	qemu_exit(false);
+}
+
+void user_error_file_line(const char *message, const char *file, uint32_t line)
+{
+	error("%s in file %s on line %"PRIu32, message, file, line);
+	qemu_exit(false);
+}
+
+void user_assert_failed(uint8_t *file, uint32_t line)
+{
+	user_error_file_line("Assert failed", (const char *) file, line);
+}
+
+void assert_failed(uint8_t *file, uint32_t line)
+{
+	user_assert_failed(file, line);
+}
+
+int main(void)
+{
+	banner("== QEMU BENCHMARK ==");
+
+	DotMatrix_Init disp_init;
+	disp_init.cols = 4;
+	disp_init.rows = 2;
+	disp_init.CS_GPIOx = &port;
+	disp_init.CS_PINx = GPIO_PIN_6;
+	disp_init.SPIx = &spi;
+	DotMatrix_Cfg *disp = dmtx_init(&disp_init);
+
+	// the debouncer case registers its own pins
+	timebase_init(5, 5);
+	debounce_init(BENCH_DEBO_PINS);
+	// the tuner's buffers, for render_tuner
+	pitch_init();
+
+	arena_seal();
+
+	bench_run(disp, buf);
+	qemu_exit(true);
+	return 0;
+}
@@ -0,0 +1,46 @@
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * Startup of the QEMU benchmark build: the Cortex-M3 core vectors only,
+ * .data copied, .bss cleared, then main(). The arena is not cleared, like
+ * on the board (startup_stm32f107xc.s).
+ */
+
+extern uint32_t _estack, _sidata, _sdata, _edata, _sbss, _ebss;
+
+void __libc_init_array(void);
+int main(void);
+
+void Reset_Handler(void);
+
+/** Faults and unexpected interrupts end the run, see bench_qemu.c */
+void Default_Handler(void);
+
+__attribute__((section(".isr_vector"), used))
+static void (*const vectors[16])(void) = {
+	(void (*)(void)) &_estack,
+	Reset_Handler,
+	Default_Handler, // NMI
+	Default_Handler, // HardFault
+	Default_Handler, // MemManage
+	Default_Handler, // BusFault
+	Default_Handler, // UsageFault
+	0, 0, 0, 0,
+	Default_Handler, // SVCall
+	Default_Handler, // DebugMon
+	0,
+	Default_Handler, // PendSV
+	Default_Handler, // SysTick, its interrupt is never enabled
+};
+
+void Reset_Handler(void)
+{
+	memcpy(&_sdata, &_sidata, (size_t) ((uint8_t *) &_edata - (uint8_t *) &_sdata));
+	memset(&_sbss, 0, (size_t) ((uint8_t *) &_ebss - (uint8_t *) &_sbss));
+
+	__libc_init_array();
+	main();
+
+	while (1);
+}
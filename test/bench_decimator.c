@@ -0,0 +1,89 @@
+#include <string.h>
+#include <time.h>
+#include <x86intrin.h>
+#include "test.h"
+#include "decimator.h"
+
+// Host benchmark of decimate(): time per input sample pair, with a check against a plain boxcar.
+//
+// Prints one JSON object per ratio, like the firmware benchmark (see User/bench.h):
+//   {"bench":"decimate","n":4,"out":256,"iters":2000,"ns_per_sample":..,"tsc_per_sample":..}
+// "tsc" are time stamp counter ticks, close to core cycles on a fixed clock host.
+// Host numbers only compare ratios and revisions, the chip is timed by bench.c.
+
+#define OUT_COUNT 256
+#define ITERATIONS 2000
+
+static uint32_t in[OUT_COUNT * DECIM_MAX_RATIO];
+static uint32_t out[OUT_COUNT];
+
+static void fill_adc(void)
+{
+	uint32_t seed = 1;
+
+	for (uint32_t i = 0; i < OUT_COUNT * DECIM_MAX_RATIO; i++) {
+		seed = seed * 1664525 + 1013904223;
+		in[i] = (seed >> 4) & 0x0FFF0FFF; // two 12-bit samples
+	}
+}
+
+/** Both channels of the output match the channel sums, scaled to 16 bits */
+static void check_output(uint32_t ratio)
+{
+	uint32_t wrong = 0;
+
+	for (uint32_t i = 0; i < OUT_COUNT; i++) {
+		uint32_t l = 0, r = 0;
+		for (uint32_t k = 0; k < ratio; k++) {
+			l += in[i * ratio + k] & 0xFFFF;
+			r += in[i * ratio + k] >> 16;
+		}
+		l = l * 16 / ratio;
+		r = r * 16 / ratio;
+
+		if (out[i] != ((r << 16) | l)) wrong++;
+	}
+
+	CHECK_EQ(wrong, 0);
+}
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void bench_ratio(uint32_t ratio)
+{
+	decimate(in, out, OUT_COUNT, ratio);
+	check_output(ratio);
+
+	// best of the runs, like cycles_min on the chip
+	uint64_t best_ns = UINT64_MAX, best_tsc = UINT64_MAX;
+	for (uint32_t i = 0; i < ITERATIONS; i++) {
+		const uint64_t t0 = now_ns();
+		const uint64_t c0 = __rdtsc();
+		decimate(in, out, OUT_COUNT, ratio);
+		const uint64_t c1 = __rdtsc();
+		const uint64_t t1 = now_ns();
+
+		if (t1 - t0 < best_ns) best_ns = t1 - t0;
+		if (c1 - c0 < best_tsc) best_tsc = c1 - c0;
+	}
+
+	const double samples = (double) OUT_COUNT * ratio;
+	printf("{\"bench\":\"decimate\",\"n\":%u,\"out\":%u,\"iters\":%u,\"ns_per_sample\":%.3f,\"tsc_per_sample\":%.3f}\n",
+		   (unsigned) ratio, OUT_COUNT, ITERATIONS, best_ns / samples, best_tsc / samples);
+}
+
+int main(void)
+{
+	fill_adc();
+
+	for (uint32_t ratio = 1; ratio <= DECIM_MAX_RATIO; ratio *= 2) {
+		bench_ratio(ratio);
+	}
+
+	return test_summary();
+}
@@ -0,0 +1,55 @@
+#include <string.h>
+#include <time.h>
+#include "stm32f1xx_hal.h"
+#include "arena.h"
+#include "timebase.h"
+#include "debounce.h"
+#include "dotmatrix.h"
+#include "fft_config.h"
+#include "pitch.h"
+#include "bench.h"
+
+// Host run of the firmware benchmark (User/bench.c), the cases that don't need the chip.
+//
+// The display is set up like user_init() does it, on registers in RAM: the
+// SPI is the null one of the dmtx_show_null case. Prints the same JSON lines
+// to stdout, the status to stderr; "cycles" are ns of the host clock, ns_mean
+// is the time per call. Host numbers only compare revisions, the chip's
+// timing is what counts (flash wait states, soft float).
+
+/** "cycles" are ns */
+uint32_t SystemCoreClock = 1000000000;
+
+static uint32_t buf[FFT_MAX_LEN * 2];
+
+static SPI_TypeDef spi = {.SR = SPI_SR_TXE};
+static GPIO_TypeDef port;
+
+uint32_t bench_host_cycles(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint32_t) ((uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec);
+}
+
+int main(void)
+{
+	DotMatrix_Init disp_init;
+	disp_init.cols = 4;
+	disp_init.rows = 2;
+	disp_init.CS_GPIOx = &port;
+	disp_init.CS_PINx = GPIO_PIN_6;
+	disp_init.SPIx = &spi;
+	DotMatrix_Cfg *disp = dmtx_init(&disp_init);
+
+	// the debouncer case registers its own pins
+	timebase_init(5, 5);
+	debounce_init(BENCH_DEBO_PINS);
+	// the tuner's buffers, for render_tuner
+	pitch_init();
+
+	arena_seal();
+
+	bench_run(disp, buf);
+	return 0;
+}
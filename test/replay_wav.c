@@ -0,0 +1,309 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "stm32f1xx_hal.h"
+#include "mxconstants.h"
+#include "dotmatrix.h"
+#include "settings.h"
+#include "meminfo.h"
+#include "fft_config.h"
+#include "capture_replay.h"
+#include "led_chain.h"
+#include "spi_emu.h"
+#include "drum_synth.h"
+#include "wav.h"
+
+/**
+ * Host replay of the visualiser: user_main.c renders a WAV file in one of
+ * its modes, the frames are decoded from what it sends to the MAX2719
+ * chain and written as plain PBM images (P1), like dump_frame() prints
+ * them. The SPI and the CS / button port are the register-level stand-in
+ * at their real addresses (spi_emu.h), the capture plays the WAV
+ * (capture_replay.h), the Flash settings select the mode.
+ *
+ *   replay_wav [-m mode] [-f fft_size] [-e every] [-o out.pbm] [-g golden.pbm] input.wav
+ *   replay_wav --make-wav out.wav
+ *
+ * -m: spectrum, spindle, wave, waterfall, vu, stereo, phase, beat, tuner
+ * -f: FFT size index, see fft_config.h
+ * -e: write every n-th frame (default 8)
+ * -g: compare with golden frames, exit with 1 on a difference
+ *
+ * The golden frames in data/replay/ are regenerated (run in test/) with
+ *   replay_wav -m <mode> -o data/replay/<mode>.pbm data/replay/replay.wav
+ * The input itself with --make-wav: a drum loop over a tone on each channel.
+ */
+
+#define SCREEN_W 32
+#define SCREEN_H 16
+
+#define MAKE_WAV_RATE 20000
+#define MAKE_WAV_MS 1200
+
+/** Render modes, in the order of user_main.c */
+static const char *mode_args[] = {
+	"spectrum", "spindle", "wave", "waterfall", "vu", "stereo", "phase", "beat", "tuner",
+};
+#define MODE_COUNT (sizeof(mode_args) / sizeof(mode_args[0]))
+
+// user_main.c
+extern DotMatrix_Cfg *disp;
+extern float y_scale;
+extern uint8_t brightness;
+extern uint8_t capture_preset;
+extern bool db_scale;
+
+static uint32_t opt_mode = 0;
+static uint32_t opt_fft = FFT_CONFIG_DEFAULT;
+static uint32_t opt_every = 8;
+
+static led_chain_t chain;
+
+/** The written frames */
+static char *frames_text;
+static size_t frames_size;
+static FILE *frames;
+
+static uint32_t frame_index;
+static uint32_t mismatches;
+
+
+// region Firmware stand-ins
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState)
+{
+	(void) GPIOx;
+	(void) GPIO_Pin;
+	(void) PinState;
+}
+
+void HAL_GPIO_TogglePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+	(void) GPIOx;
+	(void) GPIO_Pin;
+}
+
+void meminfo_paint_stack(void)
+{
+}
+
+void meminfo_report(void)
+{
+}
+
+/** The stored settings: the defaults with the selected mode and FFT size */
+bool settings_load(settings_t *out)
+{
+	memset(out, 0, sizeof(*out));
+	out->y_scale = y_scale;
+	out->brightness = brightness;
+	out->render_mode = (uint8_t) opt_mode;
+	out->capture_preset = capture_preset;
+	out->fft_size = opt_fft;
+	out->db_scale = db_scale;
+	return true;
+}
+
+void settings_changed(const settings_t *values)
+{
+	(void) values;
+}
+
+void settings_periodic(void)
+{
+}
+
+// endregion
+
+/** After each frame: decode it from the chain, check it against the transmit buffer */
+static void on_frame(void)
+{
+	char line[SCREEN_W + 2];
+
+	led_chain_feed(&chain);
+	frame_index++;
+
+	for (uint32_t y = 0; y < SCREEN_H; y++) {
+		if (led_chain_row(&chain, y) != dmtx_shown_row(disp, y)) {
+			if (mismatches++ == 0) fprintf(stderr, "frame %u row %u: the chain shows something else than was sent\n", (unsigned) frame_index, (unsigned) y);
+		}
+	}
+
+	if (frame_index % opt_every != 0) return;
+
+	fprintf(frames, "P1\n# frame %u %s\n%d %d\n", (unsigned) frame_index, mode_args[opt_mode], SCREEN_W, SCREEN_H);
+	for (int32_t y = SCREEN_H - 1; y >= 0; y--) {
+		const uint32_t row = led_chain_row(&chain, (uint32_t) y);
+		for (uint32_t x = 0; x < SCREEN_W; x++) {
+			line[x] = (char) ('0' + ((row >> x) & 1));
+		}
+		line[SCREEN_W] = '\n';
+		line[SCREEN_W + 1] = 0;
+		fputs(line, frames);
+	}
+}
+
+/** The frame number of the image holding byte `pos` of the frames text */
+static unsigned frame_at(const char *text, size_t pos)
+{
+	unsigned frame = 0;
+	const char *p = text;
+
+	while ((p = strstr(p, "# frame ")) != NULL && (size_t) (p - text) <= pos) {
+		frame = (unsigned) strtoul(p + 8, NULL, 10);
+		p++;
+	}
+
+	return frame;
+}
+
+/** Compare the frames with a golden file, print the first difference */
+static bool compare_golden(const char *path)
+{
+	FILE *f = fopen(path, "r");
+	if (!f) {
+		perror(path);
+		return false;
+	}
+
+	fseek(f, 0, SEEK_END);
+	const size_t size = (size_t) ftell(f);
+	fseek(f, 0, SEEK_SET);
+	char *golden = malloc(size + 1);
+	const bool read_ok = fread(golden, 1, size, f) == size;
+	golden[read_ok ? size : 0] = 0;
+	fclose(f);
+
+	size_t pos = 0;
+	while (pos < size && pos < frames_size && golden[pos] == frames_text[pos]) pos++;
+
+	const bool same = read_ok && size == frames_size && pos == size;
+	if (!same) {
+		fprintf(stderr, "%s: differs in frame %u\n", path, frame_at(frames_text, pos));
+	}
+
+	free(golden);
+	return same;
+}
+
+/** Write the replay input: rock_140 over a 440 Hz tone on the left and a 660 Hz one on the right */
+static int make_wav(const char *path)
+{
+	const float lead_in = DRUM_LEAD_IN_MS * MAKE_WAV_RATE / 1000.0f;
+	const uint32_t count = MAKE_WAV_MS * MAKE_WAV_RATE / 1000;
+	const uint32_t skip = (uint32_t) lead_in - MAKE_WAV_RATE / 20; // start 50 ms before the first hit
+	uint32_t *drums = malloc((skip + count) * sizeof(uint32_t));
+	uint32_t *words = malloc(count * sizeof(uint32_t));
+
+	drum_render(&drum_loops[2], MAKE_WAV_RATE, drums, skip + count);
+
+	for (uint32_t i = 0; i < count; i++) {
+		const double t = (double) i / MAKE_WAV_RATE;
+		const double drum = (double) (drums[skip + i] & 0xFFFF) - 32768;
+		const double swell = 0.5 + 0.5 * sin(2 * M_PI * 0.8 * t); // the levels move
+
+		double left = 0.3 * drum + 2500 * swell * sin(2 * M_PI * 440 * t);
+		double right = 0.2 * drum + 3500 * (1 - swell) * sin(2 * M_PI * 660 * t + 1);
+		left = fmax(-32768, fmin(32767, left));
+		right = fmax(-32768, fmin(32767, right));
+
+		words[i] = ((uint32_t) lround(left + 32768) & 0xFFFF) | ((uint32_t) lround(right + 32768) << 16);
+	}
+
+	const bool ok = wav_write(path, MAKE_WAV_RATE, words, count);
+	free(drums);
+	free(words);
+	return ok ? 0 : 1;
+}
+
+static int usage(void)
+{
+	fprintf(stderr, "usage: replay_wav [-m mode] [-f fft_size] [-e every] [-o out.pbm] [-g golden.pbm] input.wav\n"
+					"       replay_wav --make-wav out.wav\n");
+	return 2;
+}
+
+int main(int argc, char **argv)
+{
+	const char *out_path = NULL;
+	const char *golden_path = NULL;
+	const char *wav_path = NULL;
+
+	for (int i = 1; i < argc; i++) {
+		const char *arg = argv[i];
+		const char *val = i + 1 < argc ? argv[i + 1] : NULL;
+
+		if (strcmp(arg, "--make-wav") == 0 && val) {
+			return make_wav(val);
+		} else if (strcmp(arg, "-m") == 0 && val) {
+			for (opt_mode = 0; opt_mode < MODE_COUNT && strcmp(val, mode_args[opt_mode]) != 0; opt_mode++);
+			if (opt_mode == MODE_COUNT) return usage();
+			i++;
+		} else if (strcmp(arg, "-f") == 0 && val) {
+			opt_fft = (uint32_t) atoi(val);
+			if (opt_fft >= FFT_CONFIG_COUNT) return usage();
+			i++;
+		} else if (strcmp(arg, "-e") == 0 && val) {
+			opt_every = (uint32_t) atoi(val);
+			if (opt_every == 0) return usage();
+			i++;
+		} else if (strcmp(arg, "-o") == 0 && val) {
+			out_path = argv[++i];
+		} else if (strcmp(arg, "-g") == 0 && val) {
+			golden_path = argv[++i];
+		} else if (arg[0] != '-' && !wav_path) {
+			wav_path = arg;
+		} else {
+			return usage();
+		}
+	}
+
+	if (!wav_path) return usage();
+
+	wav_t wav;
+	if (!wav_read(wav_path, &wav)) return 2;
+
+	spi_emu_init_at(SPI1, SPI1_CS_GPIO_Port);
+	spi_emu_set_idr(0xFFFF); // the buttons pull low, none pressed
+	led_chain_init(&chain, 4, 2);
+	frames = open_memstream(&frames_text, &frames_size);
+
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	const uint32_t count = capture_replay_run(wav.words, wav.count, wav.rate, on_frame);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	fclose(frames);
+
+	const double host_s = (double) (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) * 1e-9;
+	const double audio_s = (double) wav.count / wav.rate;
+
+	// the frames are rendered back to back, the audio rate is the frame rate without render time
+	printf("%s: %u frames, %.2f s of audio (%.1f fps), host %.3f ms per frame\n",
+		   mode_args[opt_mode], (unsigned) count, audio_s, count / audio_s, count ? host_s * 1000 / count : 0);
+
+	bool ok = count > 0 && mismatches == 0 && chain.stray_words == 0 && chain.lost_words == 0;
+	if (chain.stray_words || chain.lost_words) {
+		fprintf(stderr, "%u frames sent outside CS, %u log overflows\n", (unsigned) chain.stray_words, (unsigned) chain.lost_words);
+	}
+	if (chain.drv[0].intensity != brightness) {
+		fprintf(stderr, "intensity %u, brightness %u\n", chain.drv[0].intensity, brightness);
+		ok = false;
+	}
+
+	if (out_path) {
+		FILE *f = fopen(out_path, "w");
+		if (!f || fwrite(frames_text, 1, frames_size, f) != frames_size) {
+			perror(out_path);
+			ok = false;
+		}
+		if (f) fclose(f);
+	}
+
+	if (golden_path && !compare_golden(golden_path)) ok = false;
+
+	free(frames_text);
+	wav_free(&wav);
+	return ok ? 0 : 1;
+}
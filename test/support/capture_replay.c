@@ -0,0 +1,91 @@
+#include <setjmp.h>
+#include <stddef.h>
+#include "capture_replay.h"
+#include "user_main.h"
+
+static const uint32_t *rec_words;
+static uint32_t rec_count;
+static uint32_t rec_rate;
+static void (*rec_frame_cb)(void);
+
+/** Position in the recording, samples */
+static uint32_t rec_pos;
+static uint32_t rec_frames;
+
+/** Sample clock (ms) */
+static ms_time_t rec_ms;
+
+static jmp_buf rec_end;
+
+
+void capture_init(void)
+{
+}
+
+
+void capture_start(uint32_t *buf, uint32_t count)
+{
+	if (count > rec_count - rec_pos) {
+		longjmp(rec_end, 1);
+	}
+
+	for (uint32_t i = 0; i < count; i++) {
+		buf[i] = rec_words[rec_pos + i];
+	}
+	rec_pos += count;
+
+	// SysTick for each ms of audio up to the frame's last sample
+	const ms_time_t now = (ms_time_t) ((uint64_t) rec_pos * 1000 / rec_rate);
+	while (rec_ms < now) {
+		rec_ms++;
+		timebase_ms_cb();
+	}
+
+	capture_complete_cb();
+	rec_frames++;
+
+	if (rec_frame_cb) rec_frame_cb();
+}
+
+
+void capture_set_rate(uint32_t rate, uint32_t oversample)
+{
+	(void) rate;
+	(void) oversample;
+}
+
+
+float capture_sample_rate(void)
+{
+	return (float) rec_rate;
+}
+
+
+ms_time_t capture_time(void)
+{
+	return rec_ms;
+}
+
+
+bool capture_busy(void)
+{
+	return false;
+}
+
+
+uint32_t capture_replay_run(const uint32_t *words, uint32_t count, uint32_t rate, void (*frame_cb)(void))
+{
+	rec_words = words;
+	rec_count = count;
+	rec_rate = rate;
+	rec_frame_cb = frame_cb;
+	rec_pos = 0;
+	rec_frames = 0;
+	rec_ms = 0;
+
+	if (setjmp(rec_end) == 0) {
+		user_main();
+	}
+
+	return rec_frames;
+}
@@ -0,0 +1,36 @@
+#ifndef CAPTURE_REPLAY_H
+#define CAPTURE_REPLAY_H
+
+/**
+ * Host implementation of capture.h that plays recorded sample words
+ * instead of the ADCs, for running user_main.c on the host.
+ *
+ * capture_start() fills the frame from the recording at once and renders
+ * it (capture_complete_cb()) before it returns, so capture_busy() is
+ * never true. The frames are back to back, none are missed while one
+ * renders. The sample clock advances by the frame length, and SysTick
+ * (timebase_ms_cb()) is run for each ms of it, so ms_now() and the timer
+ * tasks follow the audio too.
+ *
+ * The recording has its own sample rate, the selected capture preset is
+ * ignored.
+ */
+
+#include <stdint.h>
+#include "capture.h"
+
+/**
+ * @brief Run user_main() on a recording, return when it runs out
+ *
+ * user_main() never returns; it is left with a longjmp() from the
+ * capture_start() that finds too few samples. Only one run per process.
+ *
+ * @param words : sample words, see capture.h
+ * @param count : number of sample words
+ * @param rate : sample rate (Hz)
+ * @param frame_cb : called after each rendered frame, can be NULL
+ * @return number of frames rendered
+ */
+uint32_t capture_replay_run(const uint32_t *words, uint32_t count, uint32_t rate, void (*frame_cb)(void));
+
+#endif // CAPTURE_REPLAY_H
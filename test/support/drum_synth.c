@@ -0,0 +1,120 @@
+#include <math.h>
+#include <string.h>
+#include <stdbool.h>
+#include "drum_synth.h"
+
+const drum_loop_t drum_loops[] = {
+	// steps: 1 e + a 2 e + a 3 e + a 4 e + a
+	{"four_on_floor_120", 120,
+	 "x...x...x...x...",
+	 "................",
+	 "..x...x...x...x."},
+	{"backbeat_100", 100,
+	 "x.......x.x.....",
+	 "....x.......x...",
+	 "x.x.x.x.x.x.x.x."},
+	{"rock_140", 140,
+	 "x.....x.x.......",
+	 "....x.......x...",
+	 "x.x.x.x.x.x.x.x."},
+	{"halftime_85", 85,
+	 "x..........x....",
+	 "........x.......",
+	 "x.x.x.x.x.x.x.x."},
+	{"kick_only_128", 128,
+	 "x...x...x...x...",
+	 "................",
+	 "................"},
+};
+
+const uint32_t drum_loop_count = sizeof(drum_loops) / sizeof(drum_loops[0]);
+
+static uint32_t seed;
+
+/** Uniform noise -1..1 */
+static float noise(void)
+{
+	seed = seed * 1664525 + 1013904223;
+	return (float) (seed >> 8) / (1 << 23) - 1.0f;
+}
+
+/** Time of a step (ms) */
+static float hit_ms(const drum_loop_t *loop, uint32_t step)
+{
+	return DRUM_LEAD_IN_MS + step * 60000.0f / loop->bpm / 4;
+}
+
+/** Add one hit starting at sample `start` */
+static void add_hit(float *mix, uint32_t count, uint32_t start, float rate, char instrument)
+{
+	float phase = 0;
+	float prev = 0;
+
+	for (uint32_t i = start; i < count; i++) {
+		const float t = (i - start) / rate;
+		float v;
+
+		if (instrument == 'k') {
+			if (t > 0.4f) break;
+			const float f = 50 + 100 * expf(-t / 0.03f); // pitch drop
+			phase += 2 * (float) M_PI * f / rate;
+			v = 20000 * expf(-t / 0.08f) * sinf(phase);
+		} else if (instrument == 's') {
+			if (t > 0.3f) break;
+			phase += 2 * (float) M_PI * 190 / rate;
+			v = expf(-t / 0.06f) * (9000 * noise() + 4000 * sinf(phase));
+		} else {
+			if (t > 0.1f) break;
+			const float n = noise();
+			v = 7000 * expf(-t / 0.02f) * (n - prev); // first difference: high-passed
+			prev = n;
+		}
+
+		mix[i] += v;
+	}
+}
+
+void drum_render(const drum_loop_t *loop, float rate, uint32_t *out, uint32_t count)
+{
+	// the float mix goes in the output buffer, converted in place at the end
+	float *mix = (float *) out;
+	seed = 12345;
+
+	for (uint32_t i = 0; i < count; i++) {
+		mix[i] = 60 * noise(); // noise floor
+	}
+
+	const float duration_ms = count * 1000.0f / rate;
+	for (uint32_t s = 0; hit_ms(loop, s) < duration_ms; s++) {
+		const uint32_t start = (uint32_t) lroundf(hit_ms(loop, s) * rate / 1000);
+		const uint32_t k = s % DRUM_STEPS;
+
+		if (loop->kick[k] == 'x') add_hit(mix, count, start, rate, 'k');
+		if (loop->snare[k] == 'x') add_hit(mix, count, start, rate, 's');
+		if (loop->hat[k] == 'x') add_hit(mix, count, start, rate, 'h');
+	}
+
+	for (uint32_t i = 0; i < count; i++) {
+		long v = lroundf(32768 + mix[i]);
+		if (v < 0) v = 0;
+		if (v > 65535) v = 65535;
+		out[i] = (uint32_t) v | ((uint32_t) v << 16);
+	}
+}
+
+uint32_t drum_onsets(const drum_loop_t *loop, const char *instruments, float duration_ms, float *times, uint32_t max_count)
+{
+	const bool kick = strchr(instruments, 'k') != NULL;
+	const bool snare = strchr(instruments, 's') != NULL;
+	const bool hat = strchr(instruments, 'h') != NULL;
+	uint32_t n = 0;
+
+	for (uint32_t s = 0; hit_ms(loop, s) < duration_ms && n < max_count; s++) {
+		const uint32_t k = s % DRUM_STEPS;
+		if ((kick && loop->kick[k] == 'x') || (snare && loop->snare[k] == 'x') || (hat && loop->hat[k] == 'x')) {
+			times[n++] = hit_ms(loop, s);
+		}
+	}
+
+	return n;
+}
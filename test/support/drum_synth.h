@@ -0,0 +1,54 @@
+#ifndef DRUM_SYNTH_H
+#define DRUM_SYNTH_H
+
+/**
+ * Synthetic drum loops with known hit times, for the beat detection tests.
+ *
+ * A loop is a 16-step pattern per instrument (one bar of 16th notes),
+ * repeated at a tempo. Kick: a falling sine; snare: a noise burst with a
+ * tone; hat: short high-passed noise. The output is 16-bit sample words
+ * like the decimator's (left channel in the low halfword, mid scale 32768),
+ * with a quiet noise floor, and the first hit after DRUM_LEAD_IN_MS.
+ * Deterministic: the noise has a fixed seed.
+ */
+
+#include <stdint.h>
+
+#define DRUM_STEPS 16
+
+/** Silence before the first hit (ms) */
+#define DRUM_LEAD_IN_MS 500
+
+typedef struct {
+	const char *name;
+	float bpm;
+	const char *kick;  //!< DRUM_STEPS chars, 'x' = hit
+	const char *snare;
+	const char *hat;
+} drum_loop_t;
+
+/** The labelled loops */
+extern const drum_loop_t drum_loops[];
+extern const uint32_t drum_loop_count;
+
+/**
+ * @brief Render a loop
+ * @param loop : the pattern
+ * @param rate : sample rate (Hz)
+ * @param out : sample words
+ * @param count : number of samples
+ */
+void drum_render(const drum_loop_t *loop, float rate, uint32_t *out, uint32_t count);
+
+/**
+ * @brief Get the labelled onset times up to a length
+ * @param loop : the pattern
+ * @param instruments : which hits count, any of 'k', 's', 'h' (kick, snare, hat)
+ * @param duration_ms : length of the rendered audio
+ * @param times : output (ms), max_count long
+ * @param max_count : size of times
+ * @return number of onsets
+ */
+uint32_t drum_onsets(const drum_loop_t *loop, const char *instruments, float duration_ms, float *times, uint32_t max_count);
+
+#endif // DRUM_SYNTH_H
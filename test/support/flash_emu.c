@@ -0,0 +1,144 @@
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include "stm32f1xx_hal.h"
+#include "flash_emu.h"
+
+#define EMU_SIZE (FLASH_EMU_PAGES * FLASH_PAGE_SIZE)
+
+static uint8_t *flash;
+static bool locked = true;
+
+static bool power_lost;
+static bool loss_armed;
+static uint32_t programs_left;
+static bool tear_next_erase;
+
+static uint32_t erase_count[FLASH_EMU_PAGES];
+
+
+void flash_emu_init(void)
+{
+	if (flash == NULL) {
+		flash = mmap((void *) FLASH_EMU_BASE, EMU_SIZE, PROT_READ | PROT_WRITE,
+					 MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+		if (flash != (uint8_t *) FLASH_EMU_BASE) {
+			fprintf(stderr, "Can't map the emulated Flash at 0x%08x\n", FLASH_EMU_BASE);
+			exit(2);
+		}
+	}
+
+	memset(flash, 0xFF, EMU_SIZE);
+	memset(erase_count, 0, sizeof(erase_count));
+	flash_emu_power_on();
+}
+
+void flash_emu_power_loss_after(uint32_t count)
+{
+	loss_armed = true;
+	programs_left = count;
+}
+
+void flash_emu_power_loss_in_erase(void)
+{
+	tear_next_erase = true;
+}
+
+void flash_emu_power_on(void)
+{
+	power_lost = false;
+	loss_armed = false;
+	tear_next_erase = false;
+	locked = true;
+}
+
+bool flash_emu_power_lost(void)
+{
+	return power_lost;
+}
+
+uint32_t flash_emu_erase_count(int page)
+{
+	return erase_count[page];
+}
+
+uint8_t *flash_emu_page(int page)
+{
+	return flash + page * FLASH_PAGE_SIZE;
+}
+
+/** Offset of an address in the emulated region, -1 if outside */
+static int32_t emu_offset(uint32_t address, uint32_t len)
+{
+	if (address < FLASH_EMU_BASE || address + len > FLASH_EMU_BASE + EMU_SIZE) return -1;
+	return (int32_t) (address - FLASH_EMU_BASE);
+}
+
+// region HAL
+
+HAL_StatusTypeDef HAL_FLASH_Unlock(void)
+{
+	locked = false;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASH_Lock(void)
+{
+	locked = true;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASH_Program(uint32_t TypeProgram, uint32_t Address, uint64_t Data)
+{
+	if (TypeProgram != FLASH_TYPEPROGRAM_HALFWORD) return HAL_ERROR; // only these are used
+	if (locked || power_lost) return HAL_ERROR;
+	if (Address & 1) return HAL_ERROR;
+
+	int32_t off = emu_offset(Address, 2);
+	if (off < 0) return HAL_ERROR;
+
+	if (loss_armed) {
+		if (programs_left == 0) {
+			power_lost = true;
+			return HAL_ERROR;
+		}
+		programs_left--;
+	}
+
+	uint16_t *hw = (uint16_t *) (flash + off);
+	if (*hw != 0xFFFF && Data != 0) return HAL_ERROR; // PGERR
+
+	*hw = (uint16_t) Data;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASHEx_Erase(FLASH_EraseInitTypeDef *pEraseInit, uint32_t *PageError)
+{
+	*PageError = 0xFFFFFFFF;
+	if (locked || power_lost) return HAL_ERROR;
+	if (pEraseInit->TypeErase != FLASH_TYPEERASE_PAGES) return HAL_ERROR;
+
+	for (uint32_t i = 0; i < pEraseInit->NbPages; i++) {
+		uint32_t address = pEraseInit->PageAddress + i * FLASH_PAGE_SIZE;
+		int32_t off = emu_offset(address, FLASH_PAGE_SIZE);
+		if (off < 0 || off % FLASH_PAGE_SIZE) {
+			*PageError = address;
+			return HAL_ERROR;
+		}
+
+		if (tear_next_erase) {
+			memset(flash + off, 0xFF, FLASH_PAGE_SIZE / 2);
+			power_lost = true;
+			*PageError = address;
+			return HAL_ERROR;
+		}
+
+		memset(flash + off, 0xFF, FLASH_PAGE_SIZE);
+		erase_count[off / FLASH_PAGE_SIZE]++;
+	}
+
+	return HAL_OK;
+}
+
+// endregion
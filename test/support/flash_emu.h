@@ -0,0 +1,45 @@
+#ifndef FLASH_EMU_H
+#define FLASH_EMU_H
+
+/**
+ * RAM-backed stand-in for the HAL Flash driver, for the settings store.
+ *
+ * The two settings pages are mapped at their real address (the test is
+ * linked with _settings_start there, non-PIE), so the 32-bit addresses
+ * the code passes to the HAL stay valid on a 64-bit host.
+ *
+ * Programming behaves like the F1 Flash: a halfword must be erased
+ * (0xFFFF) unless it's written to 0. A power loss can be scheduled;
+ * from then on writes and erases fail and leave the memory as it is,
+ * until flash_emu_power_on() (a reboot).
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/** Address of the settings pages (_settings_start) */
+#define FLASH_EMU_BASE 0x0803F000
+#define FLASH_EMU_PAGES 2
+
+/** Map the pages and erase them */
+void flash_emu_init(void);
+
+/** Lose power after `count` more halfword programs (0 = before the next one) */
+void flash_emu_power_loss_after(uint32_t count);
+
+/** Lose power halfway through the next page erase: the first half is erased */
+void flash_emu_power_loss_in_erase(void);
+
+/** Power back on, writes work again */
+void flash_emu_power_on(void);
+
+/** Check if the power is lost */
+bool flash_emu_power_lost(void);
+
+/** Number of erases of a page so far */
+uint32_t flash_emu_erase_count(int page);
+
+/** Pointer to a page */
+uint8_t *flash_emu_page(int page);
+
+#endif // FLASH_EMU_H
@@ -0,0 +1,15 @@
+/**
+ * Host replacement for the arena region of the linker script
+ * (_sarena / _earena in STM32F107VCTx_FLASH.ld).
+ */
+
+__asm__(
+	".pushsection .bss\n"
+	".balign 8\n"
+	".globl _sarena\n"
+	"_sarena:\n"
+	".skip 0x10000\n"
+	".globl _earena\n"
+	"_earena:\n"
+	".popsection\n"
+);
@@ -0,0 +1,22 @@
+#include <stdint.h>
+
+/**
+ * C version of arm_bitreversal_32 from arm_bitreversal2.S (ARM assembly),
+ * used by arm_cfft_f32(). The table holds pairs of byte offsets of complex
+ * values to swap.
+ */
+void arm_bitreversal_32(uint32_t *pSrc, const uint16_t bitRevLen, const uint16_t *pBitRevTable)
+{
+	for (uint32_t i = 0; i + 1 < bitRevLen; i += 2) {
+		const uint32_t a = pBitRevTable[i] >> 2;
+		const uint32_t b = pBitRevTable[i + 1] >> 2;
+
+		uint32_t tmp = pSrc[a];
+		pSrc[a] = pSrc[b];
+		pSrc[b] = tmp;
+
+		tmp = pSrc[a + 1];
+		pSrc[a + 1] = pSrc[b + 1];
+		pSrc[b + 1] = tmp;
+	}
+}
@@ -0,0 +1,45 @@
+#ifndef HOST_CMSIS_H
+#define HOST_CMSIS_H
+
+/**
+ * Host stand-ins for the Cortex-M3 intrinsics, included before every
+ * source in the host test build (-include).
+ *
+ * The CMSIS core headers are used for the register layouts, only their
+ * inline assembly is replaced: the intrinsics headers are marked as
+ * already included and the few functions the code uses are defined here.
+ */
+
+#include <stdint.h>
+
+#define __CORE_CMINSTR_H
+#define __CORE_CMFUNC_H
+
+static inline void __NOP(void) {}
+static inline void __DMB(void) { __sync_synchronize(); }
+static inline void __DSB(void) { __sync_synchronize(); }
+static inline void __ISB(void) {}
+static inline void __disable_irq(void) {}
+static inline void __enable_irq(void) {}
+static inline uint32_t __CLZ(uint32_t value) { return value ? (uint32_t) __builtin_clz(value) : 32; }
+static inline uint32_t __ROR(uint32_t value, uint32_t shift)
+{
+	shift &= 31;
+	return shift ? (value >> shift) | (value << (32 - shift)) : value;
+}
+static inline uint32_t __RBIT(uint32_t value)
+{
+	uint32_t r = 0;
+	for (int i = 0; i < 32; i++, value >>= 1) r = (r << 1) | (value & 1);
+	return r;
+}
+static inline int32_t __SSAT(int32_t value, uint32_t bits)
+{
+	const int32_t max = (1 << (bits - 1)) - 1;
+	return value > max ? max : (value < -max - 1 ? -max - 1 : value);
+}
+static inline uint32_t __get_MSP(void) { return 0; }
+static inline uint32_t __get_PRIMASK(void) { return 0; }
+static inline void __set_PRIMASK(uint32_t primask) { (void) primask; }
+
+#endif // HOST_CMSIS_H
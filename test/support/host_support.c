@@ -0,0 +1,20 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "user_main.h"
+
+/**
+ * Host replacements for what the firmware gets from user_main.c,
+ * for the tests that don't link it. The arena is in host_arena.c.
+ */
+
+void user_error_file_line(const char *message, const char *file, uint32_t line)
+{
+	fprintf(stderr, "%s in file %s on line %u\n", message, file, (unsigned) line);
+	abort();
+}
+
+void user_assert_failed(uint8_t *file, uint32_t line)
+{
+	user_error_file_line("Assert failed", (const char *) file, line);
+}
@@ -0,0 +1,106 @@
+#include <string.h>
+#include "led_chain.h"
+#include "max2719.h"
+
+void led_chain_init(led_chain_t *chain, uint32_t cols, uint32_t rows)
+{
+	memset(chain, 0, sizeof(*chain));
+	chain->cols = cols;
+	chain->rows = rows;
+
+	for (uint32_t n = 0; n < LED_CHAIN_MAX; n++) {
+		chain->drv[n].shutdown = true;
+	}
+}
+
+/** CS went high: the word in the shift register is executed */
+static void latch(led_driver_t *drv)
+{
+	const uint8_t reg = (uint8_t) ((drv->shift >> 8) & 0x0F);
+	const uint8_t data = (uint8_t) drv->shift;
+
+	switch (reg) {
+		case MAX2719_CMD_NOOP:
+			break;
+
+		case MAX2719_CMD_DECODE_MODE:
+			drv->decode_mode = data;
+			break;
+
+		case MAX2719_CMD_INTENSITY:
+			drv->intensity = data & 0x0F;
+			break;
+
+		case MAX2719_CMD_SCAN_LIMIT:
+			drv->scan_limit = data & 0x07;
+			break;
+
+		case MAX2719_CMD_SHUTDOWN:
+			drv->shutdown = !(data & 1);
+			break;
+
+		case MAX2719_CMD_DISPLAY_TEST:
+			drv->test = data & 1;
+			break;
+
+		default:
+			if (reg >= MAX2719_CMD_DIGIT0 && reg <= MAX2719_CMD_DIGIT7) {
+				drv->digits[reg - MAX2719_CMD_DIGIT0] = data;
+			}
+			break;
+	}
+}
+
+void led_chain_feed(led_chain_t *chain)
+{
+	const spi_emu_log_t *log = spi_emu_log();
+	const uint32_t chain_len = chain->cols * chain->rows;
+	uint32_t w = 0;
+
+	if (log->word_count == SPI_EMU_MAX_WORDS || log->cs_count == SPI_EMU_MAX_CS) {
+		chain->lost_words++;
+	}
+
+	for (uint32_t c = 0; c < log->cs_count; c++) {
+		// frames between the CS periods
+		while (w < log->word_count && !log->words_cs_low[w]) {
+			chain->stray_words++;
+			w++;
+		}
+
+		for (uint32_t i = 0; i < log->cs_frames[c] && w < log->word_count; i++, w++) {
+			for (uint32_t n = chain_len - 1; n > 0; n--) {
+				chain->drv[n].shift = chain->drv[n - 1].shift;
+			}
+			chain->drv[0].shift = log->words[w];
+		}
+
+		for (uint32_t n = 0; n < chain_len; n++) {
+			latch(&chain->drv[n]);
+		}
+	}
+
+	chain->stray_words += log->word_count - w;
+	spi_emu_clear();
+}
+
+uint32_t led_chain_row(const led_chain_t *chain, uint32_t y)
+{
+	if (y >= chain->rows * 8) return 0;
+
+	uint32_t row = 0;
+	for (uint32_t cx = 0; cx < chain->cols; cx++) {
+		const led_driver_t *drv = &chain->drv[(y >> 3) * chain->cols + cx];
+		uint8_t bits = drv->digits[y & 7];
+
+		if (drv->test) {
+			bits = 0xFF;
+		} else if (drv->shutdown || drv->decode_mode != 0 || (y & 7) > drv->scan_limit) {
+			bits = 0;
+		}
+
+		row |= (uint32_t) bits << (cx * 8);
+	}
+
+	return row;
+}
@@ -0,0 +1,62 @@
+#ifndef LED_CHAIN_H
+#define LED_CHAIN_H
+
+/**
+ * Model of the display: a daisy chain of MAX2719 drivers fed from the
+ * spi_emu log, decoded back into pixels.
+ *
+ * Each driver has a 16-bit shift register; a frame sent with CS low
+ * enters the first driver (next to the MCU) and pushes the others' down
+ * the chain. When CS goes high, every driver executes the word in its
+ * shift register. Only the registers a frame needs are modelled: the
+ * digits, intensity, shutdown, scan limit, decode mode and display test.
+ *
+ * The pixels follow the board: driver n covers the 8x8 block at column
+ * n % cols, block row n / cols; digit d is the block's row d, bit b its
+ * column b (the framebuffer bit order of dotmatrix.h).
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "spi_emu.h"
+
+#define LED_CHAIN_MAX 8
+
+typedef struct {
+	uint16_t shift;
+	uint8_t digits[8];
+	uint8_t intensity;
+	uint8_t scan_limit;
+	uint8_t decode_mode;
+	bool shutdown; //!< in shutdown (the reset state)
+	bool test;
+} led_driver_t;
+
+typedef struct {
+	uint32_t cols;
+	uint32_t rows;
+	led_driver_t drv[LED_CHAIN_MAX];
+
+	uint32_t stray_words; //!< frames sent with CS high, they don't reach the chain
+	uint32_t lost_words; //!< the log was full, the model missed frames
+} led_chain_t;
+
+/** Reset the drivers (power-on state) */
+void led_chain_init(led_chain_t *chain, uint32_t cols, uint32_t rows);
+
+/** Run the frames of the log through the chain, then clear the log */
+void led_chain_feed(led_chain_t *chain);
+
+/**
+ * @brief Get a pixel row as shown
+ *
+ * A driver's part is all set in display test, blank while shut down, in a
+ * decode mode or past the scan limit, otherwise its digit register.
+ *
+ * @param chain : the model
+ * @param y : pixel Y
+ * @return the row in framebuffer format
+ */
+uint32_t led_chain_row(const led_chain_t *chain, uint32_t y);
+
+#endif // LED_CHAIN_H
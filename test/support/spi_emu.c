@@ -0,0 +1,272 @@
+#include <signal.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <ucontext.h>
+#include <sys/mman.h>
+#include "spi_emu.h"
+
+#if !defined(__x86_64__) || !defined(__linux__)
+#error "spi_emu single-steps the register accesses, x86-64 Linux only"
+#endif
+
+#define PAGE_SIZE 4096
+#define GPIO_OFFSET 0x400
+
+/** x86 trap flag, single step */
+#define EFLAGS_TF 0x100
+
+/** Never a frame: frames are 16 bits */
+#define DR_IDLE 0xDEAD0000u
+
+/** The mapped pages: one for spi_emu_init(), the SPI's and the GPIO port's for spi_emu_init_at() */
+static uint8_t *pages[2];
+static uint32_t page_count;
+
+static SPI_TypeDef *spi;
+static GPIO_TypeDef *gpio;
+
+static spi_emu_log_t log_;
+
+// shifter model
+static bool cs_low;
+static bool busy;
+static bool tx_full;
+static uint16_t pending;
+static uint32_t shift_left;
+
+
+static void protect(bool on)
+{
+	for (uint32_t i = 0; i < page_count; i++) {
+		mprotect(pages[i], PAGE_SIZE, on ? PROT_NONE : (PROT_READ | PROT_WRITE));
+	}
+}
+
+static bool in_pages(const uint8_t *addr)
+{
+	for (uint32_t i = 0; i < page_count; i++) {
+		if (addr >= pages[i] && addr < pages[i] + PAGE_SIZE) return true;
+	}
+	return false;
+}
+
+/** A frame moves to the shift register */
+static void start_frame(uint16_t word)
+{
+	busy = true;
+	shift_left = SPI_EMU_FRAME_TICKS;
+
+	if (log_.word_count < SPI_EMU_MAX_WORDS) {
+		log_.words[log_.word_count] = word;
+		log_.words_cs_low[log_.word_count] = cs_low;
+		log_.word_count++;
+	}
+
+	if (cs_low && log_.cs_count > 0) {
+		log_.cs_frames[log_.cs_count - 1]++;
+	}
+}
+
+/** Time passes, one register access */
+static void tick(void)
+{
+	if (busy && --shift_left == 0) {
+		if (tx_full) {
+			tx_full = false;
+			start_frame(pending);
+		} else {
+			busy = false;
+		}
+	}
+}
+
+static void dr_write(uint16_t word)
+{
+	if (!(spi->CR1 & SPI_CR1_SPE)) {
+		log_.disabled_writes++;
+		return;
+	}
+
+	if (tx_full) {
+		log_.overruns++;
+		pending = word;
+	} else if (!busy) {
+		start_frame(word);
+	} else {
+		tx_full = true;
+		pending = word;
+	}
+}
+
+static void set_cs(bool low)
+{
+	if (low == cs_low) return;
+
+	if (low) {
+		if (log_.cs_count < SPI_EMU_MAX_CS) {
+			log_.cs_frames[log_.cs_count++] = 0;
+		}
+	} else if (busy) {
+		log_.cs_glitches++;
+	}
+
+	cs_low = low;
+}
+
+/** Access to the fake registers: update them, let the access through for one instruction */
+static void on_segv(int sig, siginfo_t *info, void *ctx)
+{
+	uint8_t *addr = info->si_addr;
+
+	if (!in_pages(addr)) {
+		signal(sig, SIG_DFL);
+		return; // faults again, with the default action
+	}
+
+	tick();
+	protect(false);
+
+	spi->SR = (tx_full ? 0 : SPI_SR_TXE) | (busy ? SPI_SR_BSY : 0);
+	spi->DR = DR_IDLE;
+	gpio->BSRR = 0;
+	gpio->BRR = 0;
+
+	((ucontext_t *) ctx)->uc_mcontext.gregs[REG_EFL] |= EFLAGS_TF;
+}
+
+/** The access is done, see what was written */
+static void on_trap(int sig, siginfo_t *info, void *ctx)
+{
+	(void) sig;
+	(void) info;
+
+	if (spi->DR != DR_IDLE) {
+		dr_write((uint16_t) spi->DR);
+	}
+
+	// BSRR: set in the low half, reset in the high half; BRR: reset
+	if (gpio->BRR || (gpio->BSRR >> 16)) {
+		set_cs(true);
+	}
+	if (gpio->BSRR & 0xFFFF) {
+		set_cs(false);
+	}
+
+	protect(true);
+	((ucontext_t *) ctx)->uc_mcontext.gregs[REG_EFL] &= ~EFLAGS_TF;
+}
+
+
+/** Map a page, at `addr` if not NULL */
+static uint8_t *map_page(void *addr)
+{
+	const int fixed = addr ? MAP_FIXED_NOREPLACE : 0;
+	uint8_t *p = mmap(addr, PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | fixed, -1, 0);
+
+	if (p == MAP_FAILED || (addr && p != addr)) {
+		perror("spi_emu: mmap");
+		exit(2);
+	}
+
+	return p;
+}
+
+static void arm_handlers(void)
+{
+	struct sigaction sa;
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_flags = SA_SIGINFO;
+	sa.sa_sigaction = on_segv;
+	sigaction(SIGSEGV, &sa, NULL);
+	sa.sa_sigaction = on_trap;
+	sigaction(SIGTRAP, &sa, NULL);
+}
+
+/** Clear the registers and the model, protect the pages */
+static void reset(void)
+{
+	for (uint32_t i = 0; i < page_count; i++) {
+		memset(pages[i], 0, PAGE_SIZE);
+	}
+
+	cs_low = false;
+	busy = false;
+	tx_full = false;
+	spi_emu_clear();
+
+	protect(true);
+}
+
+void spi_emu_init(void)
+{
+	if (page_count == 0) {
+		pages[page_count++] = map_page(NULL);
+		arm_handlers();
+
+		spi = (SPI_TypeDef *) pages[0];
+		gpio = (GPIO_TypeDef *) (pages[0] + GPIO_OFFSET);
+	} else {
+		protect(false);
+	}
+
+	reset();
+}
+
+void spi_emu_init_at(SPI_TypeDef *spi_addr, GPIO_TypeDef *gpio_addr)
+{
+	uint8_t *spi_page = (uint8_t *) ((uintptr_t) spi_addr & ~(uintptr_t) (PAGE_SIZE - 1));
+	uint8_t *gpio_page = (uint8_t *) ((uintptr_t) gpio_addr & ~(uintptr_t) (PAGE_SIZE - 1));
+
+	if (page_count == 0) {
+		pages[page_count++] = map_page(spi_page);
+		if (gpio_page != spi_page) {
+			pages[page_count++] = map_page(gpio_page);
+		}
+		arm_handlers();
+
+		spi = spi_addr;
+		gpio = gpio_addr;
+	} else {
+		protect(false);
+	}
+
+	reset();
+}
+
+void spi_emu_set_idr(uint16_t value)
+{
+	protect(false);
+	gpio->IDR = value;
+	protect(true);
+}
+
+SPI_TypeDef *spi_emu_spi(void)
+{
+	return spi;
+}
+
+GPIO_TypeDef *spi_emu_gpio(void)
+{
+	return gpio;
+}
+
+void spi_emu_clear(void)
+{
+	memset(&log_, 0, sizeof(log_));
+}
+
+const spi_emu_log_t *spi_emu_log(void)
+{
+	return &log_;
+}
+
+bool spi_emu_cs_low(void)
+{
+	return cs_low;
+}
+
+bool spi_emu_idle(void)
+{
+	return !busy && !tx_full;
+}
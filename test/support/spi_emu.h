@@ -0,0 +1,78 @@
+#ifndef SPI_EMU_H
+#define SPI_EMU_H
+
+/**
+ * Register-level stand-in for an F1 SPI and the GPIO port of its CS pin.
+ *
+ * The fake registers sit in a page with no access rights. Every access
+ * faults, the handler runs the peripheral model and single-steps the
+ * access (x86-64 Linux only). That way a DR write is seen when it
+ * happens, like on the chip: TXE drops while the transmit buffer is full,
+ * BSY is set while a frame is shifted out, and each frame takes a few
+ * register accesses to leave.
+ *
+ * The frames on the wire are recorded with the CS level at their start.
+ * Protocol errors are counted: DR written with TXE clear, or with SPE
+ * off, and CS released while a frame is still being shifted.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "stm32f1xx_hal.h"
+
+/** Register accesses it takes to shift out one frame */
+#define SPI_EMU_FRAME_TICKS 3
+
+#define SPI_EMU_MAX_WORDS 256
+#define SPI_EMU_MAX_CS 64
+
+typedef struct {
+	uint16_t words[SPI_EMU_MAX_WORDS]; //!< frames in the order they left the shift register
+	bool words_cs_low[SPI_EMU_MAX_WORDS]; //!< CS was low when the frame started
+	uint32_t word_count;
+
+	/** Frames sent within each CS low period */
+	uint32_t cs_frames[SPI_EMU_MAX_CS];
+	uint32_t cs_count;
+
+	uint32_t overruns; //!< DR written with TXE clear
+	uint32_t disabled_writes; //!< DR written with SPE off
+	uint32_t cs_glitches; //!< CS released while BSY
+} spi_emu_log_t;
+
+/** Map the fake registers, arm the fault handler. CS starts high, SPE off. */
+void spi_emu_init(void);
+
+/**
+ * @brief Like spi_emu_init(), with the registers at the given addresses
+ *
+ * For code that uses the peripherals by their fixed CMSIS addresses
+ * (SPI1, GPIOE...). The pages holding them must be free in the process;
+ * the low 2 GB are, away from the executable. A process uses either this
+ * or spi_emu_init(), and the same addresses on each call.
+ *
+ * @param spi_addr : the SPI registers
+ * @param gpio_addr : the registers of the CS pin's port
+ */
+void spi_emu_init_at(SPI_TypeDef *spi_addr, GPIO_TypeDef *gpio_addr);
+
+/** Set the input levels of the GPIO port (IDR), 0 after init */
+void spi_emu_set_idr(uint16_t value);
+
+/** The fake peripherals */
+SPI_TypeDef *spi_emu_spi(void);
+GPIO_TypeDef *spi_emu_gpio(void);
+
+/** Clear the log (the SPE bit and CS level are kept) */
+void spi_emu_clear(void);
+
+/** What was sent since the last clear */
+const spi_emu_log_t *spi_emu_log(void);
+
+/** CS is low now */
+bool spi_emu_cs_low(void);
+
+/** The shifter is idle and the transmit buffer empty */
+bool spi_emu_idle(void);
+
+#endif // SPI_EMU_H
@@ -0,0 +1,142 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "wav.h"
+
+#define WAV_PCM 1
+
+static uint32_t le32(const uint8_t *p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static uint16_t le16(const uint8_t *p)
+{
+	return (uint16_t) (p[0] | (p[1] << 8));
+}
+
+static void put32(uint8_t *p, uint32_t v)
+{
+	for (int i = 0; i < 4; i++, v >>= 8) p[i] = (uint8_t) v;
+}
+
+static void put16(uint8_t *p, uint16_t v)
+{
+	p[0] = (uint8_t) v;
+	p[1] = (uint8_t) (v >> 8);
+}
+
+/** Signed 16-bit sample to the offset halfword */
+static uint32_t to_word_half(const uint8_t *p)
+{
+	return (uint16_t) (le16(p) ^ 0x8000);
+}
+
+bool wav_read(const char *path, wav_t *wav)
+{
+	uint8_t hdr[12];
+	uint8_t chunk[8];
+	uint8_t fmt[16];
+	bool have_fmt = false;
+
+	memset(wav, 0, sizeof(*wav));
+
+	FILE *f = fopen(path, "rb");
+	if (!f) {
+		perror(path);
+		return false;
+	}
+
+	if (fread(hdr, 1, sizeof(hdr), f) != sizeof(hdr) || memcmp(hdr, "RIFF", 4) != 0 || memcmp(hdr + 8, "WAVE", 4) != 0) {
+		fprintf(stderr, "%s: not a WAV file\n", path);
+		fclose(f);
+		return false;
+	}
+
+	while (fread(chunk, 1, sizeof(chunk), f) == sizeof(chunk)) {
+		const uint32_t size = le32(chunk + 4);
+
+		if (memcmp(chunk, "fmt ", 4) == 0 && size >= sizeof(fmt)) {
+			if (fread(fmt, 1, sizeof(fmt), f) != sizeof(fmt)) break;
+			fseek(f, (long) (size - sizeof(fmt) + (size & 1)), SEEK_CUR);
+
+			wav->channels = le16(fmt + 2);
+			wav->rate = le32(fmt + 4);
+			if (le16(fmt) != WAV_PCM || le16(fmt + 14) != 16 || wav->channels < 1 || wav->channels > 2) {
+				fprintf(stderr, "%s: only 16-bit PCM, mono or stereo\n", path);
+				break;
+			}
+			have_fmt = true;
+		} else if (memcmp(chunk, "data", 4) == 0 && have_fmt) {
+			const uint32_t frame_size = 2 * wav->channels;
+			uint8_t *data = malloc(size);
+
+			if (!data || fread(data, 1, size, f) != size) {
+				fprintf(stderr, "%s: short data chunk\n", path);
+				free(data);
+				break;
+			}
+
+			wav->count = size / frame_size;
+			wav->words = malloc(wav->count * sizeof(uint32_t) + 1);
+			for (uint32_t i = 0; i < wav->count; i++) {
+				const uint8_t *p = data + i * frame_size;
+				const uint32_t left = to_word_half(p);
+				const uint32_t right = wav->channels == 2 ? to_word_half(p + 2) : left;
+				wav->words[i] = left | (right << 16);
+			}
+
+			free(data);
+			fclose(f);
+			return true;
+		} else {
+			fseek(f, (long) (size + (size & 1)), SEEK_CUR);
+		}
+	}
+
+	if (!have_fmt) fprintf(stderr, "%s: no usable fmt and data chunks\n", path);
+	fclose(f);
+	return false;
+}
+
+bool wav_write(const char *path, uint32_t rate, const uint32_t *words, uint32_t count)
+{
+	uint8_t hdr[44];
+	const uint32_t data_size = count * 4;
+
+	memcpy(hdr, "RIFF", 4);
+	put32(hdr + 4, 36 + data_size);
+	memcpy(hdr + 8, "WAVEfmt ", 8);
+	put32(hdr + 16, 16);
+	put16(hdr + 20, WAV_PCM);
+	put16(hdr + 22, 2);
+	put32(hdr + 24, rate);
+	put32(hdr + 28, rate * 4);
+	put16(hdr + 32, 4);
+	put16(hdr + 34, 16);
+	memcpy(hdr + 36, "data", 4);
+	put32(hdr + 40, data_size);
+
+	FILE *f = fopen(path, "wb");
+	if (!f) {
+		perror(path);
+		return false;
+	}
+
+	bool ok = fwrite(hdr, 1, sizeof(hdr), f) == sizeof(hdr);
+	for (uint32_t i = 0; ok && i < count; i++) {
+		uint8_t frame[4];
+		put16(frame, (uint16_t) ((words[i] & 0xFFFF) ^ 0x8000));
+		put16(frame + 2, (uint16_t) ((words[i] >> 16) ^ 0x8000));
+		ok = fwrite(frame, 1, sizeof(frame), f) == sizeof(frame);
+	}
+
+	return fclose(f) == 0 && ok;
+}
+
+void wav_free(wav_t *wav)
+{
+	free(wav->words);
+	wav->words = NULL;
+	wav->count = 0;
+}
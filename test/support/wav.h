@@ -0,0 +1,42 @@
+#ifndef WAV_H
+#define WAV_H
+
+/**
+ * Minimal RIFF WAVE reader and writer, 16-bit PCM only.
+ *
+ * The samples are kept as capture sample words (see capture.h): left in
+ * the low halfword, right in the high one, offset to mid scale 32768 like
+ * the decimator output. A mono file has the same sample in both halves.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct {
+	uint32_t rate; //!< sample rate (Hz)
+	uint32_t channels; //!< in the file, 1 or 2
+	uint32_t count; //!< number of sample words
+	uint32_t *words; //!< malloc'd, free with wav_free()
+} wav_t;
+
+/**
+ * @brief Read a file
+ * @param path : the file
+ * @param wav : filled in
+ * @return success; the reason is printed to stderr otherwise
+ */
+bool wav_read(const char *path, wav_t *wav);
+
+/**
+ * @brief Write a stereo file
+ * @param path : the file
+ * @param rate : sample rate (Hz)
+ * @param words : sample words
+ * @param count : number of sample words
+ * @return success
+ */
+bool wav_write(const char *path, uint32_t rate, const uint32_t *words, uint32_t count);
+
+void wav_free(wav_t *wav);
+
+#endif // WAV_H
@@ -0,0 +1,50 @@
+#ifndef TEST_H
+#define TEST_H
+
+/**
+ * Minimal checks for the host tests.
+ *
+ * A failed check prints the location and is counted, the test goes on.
+ * Each test program ends with `return test_summary();`.
+ */
+
+#include <stdio.h>
+#include <math.h>
+
+static int test_checks;
+static int test_failures;
+
+#define CHECK(cond) do { \
+		test_checks++; \
+		if (!(cond)) { \
+			test_failures++; \
+			printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+		} \
+	} while (0)
+
+#define CHECK_EQ(actual, expected) do { \
+		long long a_ = (long long) (actual), e_ = (long long) (expected); \
+		test_checks++; \
+		if (a_ != e_) { \
+			test_failures++; \
+			printf("%s:%d: %s == %lld, expected %lld\n", __FILE__, __LINE__, #actual, a_, e_); \
+		} \
+	} while (0)
+
+#define CHECK_NEAR(actual, expected, tol) do { \
+		double a_ = (double) (actual), e_ = (double) (expected); \
+		test_checks++; \
+		if (!(fabs(a_ - e_) <= (tol))) { \
+			test_failures++; \
+			printf("%s:%d: %s == %g, expected %g +- %g\n", __FILE__, __LINE__, #actual, a_, e_, (double) (tol)); \
+		} \
+	} while (0)
+
+/** Print the result, returns the exit code */
+static inline int test_summary(void)
+{
+	printf("%d checks, %d failed\n", test_checks, test_failures);
+	return test_failures ? 1 : 0;
+}
+
+#endif // TEST_H
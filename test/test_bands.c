@@ -0,0 +1,187 @@
+#include <string.h>
+#include <math.h>
+#include "test.h"
+#include "dsp.h"
+#include "bands.h"
+
+// The spectrum is normalised by 1/(N * FFT_WINDOW_GAIN): tones and noise bands read the same at every FFT size
+
+#define SAMPLE_RATE 20000.0f
+
+/** Bin width of the 64-point FFT; its multiples are bin centres at all sizes */
+#define COARSE_BIN (SAMPLE_RATE / 64)
+
+/** Full scale sine amplitude and its normalised peak (see dsp_spectrum()) */
+#define AMPLITUDE 32767.0
+#define PEAK (AMPLITUDE / 2)
+
+/**
+ * The Hamming tables are symmetric, their mean is 0.54 - 0.46 / N, not 0.54:
+ * 1.3 % low at 64 points, 0.1 % at 1024.
+ */
+#define WINDOW_GAIN_TOL 0.015
+
+static uint32_t buf[FFT_MAX_LEN * 2];
+
+static uint32_t lcg = 1;
+
+/** Uniform noise in -1..1 */
+static double noise(void)
+{
+	lcg = lcg * 1664525 + 1013904223;
+	return (double) (lcg >> 8) / (1 << 23) - 1.0;
+}
+
+static uint32_t sample_word(double v)
+{
+	long s = lround(32768.0 + v);
+	if (s < 0) s = 0;
+	if (s > 65535) s = 65535;
+	return (uint32_t) s | 0x12340000; // right channel is ignored
+}
+
+static void fill_sine(uint32_t n, double freq, double amplitude)
+{
+	for (uint32_t i = 0; i < n; i++) {
+		buf[i] = sample_word(amplitude * sin(2 * M_PI * freq * i / SAMPLE_RATE));
+	}
+}
+
+/** Power spectrum of the buffer, gain 1 */
+static const float *power_spectrum(const fft_config_t *cfg)
+{
+	dsp_spectrum(buf, cfg, 1.0f, MAG_SQUARED);
+	return (const float *) buf;
+}
+
+/** The window tables match the gain the spectrum is divided by */
+static void test_window_gain(void)
+{
+	for (uint32_t c = 0; c < FFT_CONFIG_COUNT; c++) {
+		const fft_config_t *cfg = fft_config_get(c);
+
+		double sum = 0;
+		for (uint32_t i = 0; i < cfg->fft_len; i++) sum += cfg->window[i];
+
+		const double mean = sum / cfg->fft_len;
+		CHECK_NEAR(mean / FFT_WINDOW_GAIN, 1.0, WINDOW_GAIN_TOL);
+		CHECK_NEAR(mean, 0.54 - 0.46 / cfg->fft_len, 1e-5);
+	}
+}
+
+/** A full scale tone at a bin centre peaks at AMPLITUDE / 2 at every size */
+static void test_tone_peak(void)
+{
+	// away from DC and Nyquist, where the mirror image leaks into the bin
+	static const uint32_t coarse_bins[] = {3, 5, 17, 28};
+
+	for (uint32_t c = 0; c < FFT_CONFIG_COUNT; c++) {
+		const fft_config_t *cfg = fft_config_get(c);
+		const uint32_t scale = cfg->fft_len / 64;
+
+		for (uint32_t t = 0; t < sizeof(coarse_bins) / sizeof(coarse_bins[0]); t++) {
+			fill_sine(cfg->fft_len, coarse_bins[t] * COARSE_BIN, AMPLITUDE);
+			const float *bins = power_spectrum(cfg);
+
+			const double peak = sqrt(bins[coarse_bins[t] * scale]);
+			CHECK_NEAR(peak / PEAK, 1.0, WINDOW_GAIN_TOL);
+		}
+	}
+}
+
+/** Band levels of a tone don't depend on the FFT size */
+static void test_band_levels(void)
+{
+	float levels[FFT_CONFIG_COUNT][BAND_COUNT];
+	const double freq = 5 * COARSE_BIN; // 1562.5 Hz
+
+	for (uint32_t c = 0; c < FFT_CONFIG_COUNT; c++) {
+		const fft_config_t *cfg = fft_config_get(c);
+
+		bands_configure(SAMPLE_RATE, cfg->fft_len);
+		fill_sine(cfg->fft_len, freq, AMPLITUDE / 4);
+		bands_compute(power_spectrum(cfg), levels[c]);
+	}
+
+	// the band holding the tone; the low bands are at least a bin wide, so
+	// which band that is depends on the size
+	for (uint32_t c = 0; c < FFT_CONFIG_COUNT; c++) {
+		float max = 0;
+		for (uint32_t b = 0; b < BAND_COUNT; b++) {
+			if (levels[c][b] > max) max = levels[c][b];
+		}
+		CHECK_NEAR(sqrt(max) / (PEAK / 4), 1.0, WINDOW_GAIN_TOL);
+	}
+}
+
+/**
+ * White noise: the bin power falls with 1/N, the number of bins in a band
+ * grows with N, so the summed band power is the same at every size.
+ * E[bin] = var * sum(w^2) / (N * 0.54)^2; averaged over 64k samples.
+ */
+static void test_noise_band_energy(void)
+{
+	const double f_lo = 4 * COARSE_BIN, f_hi = 12 * COARSE_BIN; // 1250..3750 Hz
+	const double amplitude = 8000;
+	const double var = amplitude * amplitude / 3; // uniform
+	const uint32_t total = 65536;
+	double energies[FFT_CONFIG_COUNT];
+
+	for (uint32_t c = 0; c < FFT_CONFIG_COUNT; c++) {
+		const fft_config_t *cfg = fft_config_get(c);
+		const uint32_t n = cfg->fft_len;
+		const uint32_t lo = (uint32_t) lround(f_lo * n / SAMPLE_RATE);
+		const uint32_t hi = (uint32_t) lround(f_hi * n / SAMPLE_RATE);
+
+		double sum_w2 = 0;
+		for (uint32_t i = 0; i < n; i++) sum_w2 += cfg->window[i] * cfg->window[i];
+		const double norm = n * FFT_WINDOW_GAIN;
+		const double expected = (hi - lo) * var * sum_w2 / (norm * norm);
+
+		double energy = 0;
+		const uint32_t frames = total / n;
+		for (uint32_t f = 0; f < frames; f++) {
+			for (uint32_t i = 0; i < n; i++) buf[i] = sample_word(amplitude * noise());
+
+			const float *bins = power_spectrum(cfg);
+			for (uint32_t b = lo; b < hi; b++) energy += bins[b];
+		}
+		energy /= frames;
+		energies[c] = energy;
+
+		// 2560 bin samples per size, ~2 % standard deviation
+		CHECK_NEAR(energy / expected, 1.0, 0.08);
+	}
+
+	for (uint32_t c = 0; c < FFT_CONFIG_COUNT - 1; c++) {
+		CHECK_NEAR(energies[c] / energies[FFT_CONFIG_COUNT - 1], 1.0, 0.1);
+	}
+}
+
+/** Silence gives empty bins, DC is removed */
+static void test_silence(void)
+{
+	for (uint32_t c = 0; c < FFT_CONFIG_COUNT; c++) {
+		const fft_config_t *cfg = fft_config_get(c);
+
+		for (uint32_t i = 0; i < cfg->fft_len; i++) buf[i] = 0x8000 + 1000;
+		const float *bins = power_spectrum(cfg);
+
+		float max = 0;
+		for (uint32_t b = 0; b < cfg->fft_len / 2; b++) {
+			if (bins[b] > max) max = bins[b];
+		}
+		CHECK(max < 1e-6f);
+	}
+}
+
+int main(void)
+{
+	test_window_gain();
+	test_tone_peak();
+	test_band_levels();
+	test_noise_band_energy();
+	test_silence();
+
+	return test_summary();
+}
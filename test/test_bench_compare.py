@@ -0,0 +1,76 @@
+#!/usr/bin/env python3
+"""
+Host test of bench_compare.py on two benchmark logs (data/bench_*.log): the
+bench_host output of a -O0 and of the -O2 build.
+"""
+
+import os
+import subprocess
+import sys
+import tempfile
+import unittest
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+SCRIPT = os.path.join(HERE, '..', 'bench_compare.py')
+BEFORE = os.path.join(HERE, 'data', 'bench_before.log')
+AFTER = os.path.join(HERE, 'data', 'bench_after.log')
+
+sys.path.insert(0, os.path.dirname(SCRIPT))
+import bench_compare  # noqa: E402
+
+
+class BenchCompareTest(unittest.TestCase):
+    def setUp(self):
+        self.tmp = tempfile.TemporaryDirectory()
+
+    def tearDown(self):
+        self.tmp.cleanup()
+
+    def write_log(self, name, text):
+        path = os.path.join(self.tmp.name, name)
+        with open(path, 'w') as f:
+            f.write(text)
+        return path
+
+    def test_parse(self):
+        results = bench_compare.parse_log(BEFORE)
+        self.assertEqual(len(results), 39)  # the status lines are skipped
+        self.assertEqual(results[('render_tuner', 1024)]['cycles_mean'], 62636)
+        self.assertEqual(results[('debo_periodic_task', 8)]['n'], 8)
+
+    def test_colour_codes(self):
+        # the firmware log: colour codes before the first line
+        log = self.write_log('firmware.log',
+                             '\x1b[37m   0.000 [i] Benchmark, 72 MHz, cycle counter, overhead 6 cycles\n'
+                             '\x1b[0m{"bench":"dmtx_pack","n":0,"iters":100,"cycles_min":410,"cycles_mean":412}\n')
+        self.assertEqual(bench_compare.parse_log(log)[('dmtx_pack', 0)]['cycles_mean'], 412)
+
+    def test_compare(self):
+        rows = bench_compare.compare(bench_compare.parse_log(BEFORE), bench_compare.parse_log(AFTER), 'cycles_mean')
+        by_case = {(r[0], r[1]): r for r in rows}
+
+        self.assertEqual(len(rows), 39)
+        self.assertAlmostEqual(by_case[('frame_rows', 32)][4], 1128 / 370)
+
+    def test_missing_cases(self):
+        before = self.write_log('before.log', '{"bench":"dmtx_show","n":0,"cycles_mean":9100}\n')
+        after = self.write_log('after.log', '{"bench":"dmtx_show_null","n":0,"cycles_mean":712}\n')
+        by_case = {(r[0], r[1]): r for r in bench_compare.compare(bench_compare.parse_log(before),
+                                                                   bench_compare.parse_log(after), 'cycles_mean')}
+        self.assertIsNone(by_case[('dmtx_show', 0)][3])       # only before
+        self.assertIsNone(by_case[('dmtx_show_null', 0)][2])  # only after
+
+    def test_output(self):
+        r = subprocess.run([sys.executable, SCRIPT, BEFORE, AFTER, '--metric', 'cycles_min'],
+                           stdout=subprocess.PIPE, universal_newlines=True)
+        self.assertEqual(r.returncode, 0)
+        self.assertIn('2.50x', r.stdout)  # dmtx_pack 50 / 20
+
+    def test_empty_log_fails(self):
+        r = subprocess.run([sys.executable, SCRIPT, SCRIPT, AFTER],
+                           stdout=subprocess.PIPE, stderr=subprocess.PIPE, universal_newlines=True)
+        self.assertEqual(r.returncode, 1)
+
+
+if __name__ == '__main__':
+    unittest.main()
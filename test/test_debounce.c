@@ -0,0 +1,308 @@
+#include <string.h>
+#include "test.h"
+#include "debounce.h"
+#include "timebase.h"
+
+// Debouncer driven through fake GPIO ports, one debo_periodic_task() call per ms
+
+#define PIN_A (1 << 10)
+#define PIN_B (1 << 11)
+#define PIN_C (1 << 3)
+
+static GPIO_TypeDef port_e;
+static GPIO_TypeDef port_d;
+static GPIO_TypeDef port_c;
+
+#define MAX_EVENTS 64
+
+static struct {
+	uint32_t payload;
+	debo_event_t event;
+	uint32_t time;
+} events[MAX_EVENTS];
+static uint32_t event_count;
+
+/** Ticks since the start of the current case */
+static uint32_t now;
+
+static void record_cb(uint32_t payload, debo_event_t event)
+{
+	if (event_count < MAX_EVENTS) {
+		events[event_count].payload = payload;
+		events[event_count].event = event;
+		events[event_count].time = now;
+		event_count++;
+	}
+}
+
+static void reset_events(void)
+{
+	event_count = 0;
+	now = 0;
+}
+
+/** One ms: sample the ports and dispatch the queue */
+static void tick(void)
+{
+	now++;
+	debo_periodic_task(NULL);
+	debo_process_events();
+}
+
+static void ticks(uint32_t n)
+{
+	while (n--) tick();
+}
+
+static void set_pin(GPIO_TypeDef *port, uint16_t pin, bool level)
+{
+	if (level) {
+		port->IDR |= pin;
+	} else {
+		port->IDR &= ~(uint32_t) pin;
+	}
+}
+
+static debo_id_t add_pin(GPIO_TypeDef *port, uint16_t pin, ms_time_t debo_time, uint32_t payload)
+{
+	debo_init_t init;
+	memset(&init, 0, sizeof(init));
+	init.GPIOx = port;
+	init.pin = pin;
+	init.debo_time = debo_time;
+	init.cb_payload = payload;
+	init.callback = record_cb;
+	return debo_register_pin(&init);
+}
+
+/** A clean edge is reported on the (debo_time + 1)-th stable sample */
+static void test_clean_edge(void)
+{
+	reset_events();
+	debo_id_t id = add_pin(&port_e, PIN_A, 5, 1);
+	CHECK(id != DEBO_PIN_NONE);
+	CHECK(!debo_pin_state(id));
+
+	set_pin(&port_e, PIN_A, 1);
+	ticks(5);
+	CHECK_EQ(event_count, 0);
+	CHECK(!debo_pin_state(id));
+
+	tick();
+	CHECK_EQ(event_count, 1);
+	CHECK_EQ(events[0].event, DEBO_EV_PRESS);
+	CHECK_EQ(events[0].time, 6);
+	CHECK(debo_pin_state(id));
+
+	set_pin(&port_e, PIN_A, 0);
+	ticks(6);
+	CHECK_EQ(event_count, 2);
+	CHECK_EQ(events[1].event, DEBO_EV_RELEASE);
+	CHECK_EQ(events[1].time, 12);
+
+	CHECK(debo_remove_pin(id));
+	CHECK(!debo_remove_pin(id));
+}
+
+/** Chatter restarts the count, only a stable run of debo_time + 1 samples counts */
+static void test_chatter(void)
+{
+	static const char *pattern = "1011011101111011111"; // last run of 1s is 5 long
+	reset_events();
+	debo_id_t id = add_pin(&port_e, PIN_A, 5, 1);
+
+	for (const char *p = pattern; *p; p++) {
+		set_pin(&port_e, PIN_A, *p == '1');
+		tick();
+	}
+	CHECK_EQ(event_count, 0);
+
+	// the 6th stable sample
+	tick();
+	CHECK_EQ(event_count, 1);
+	CHECK_EQ(events[0].event, DEBO_EV_PRESS);
+
+	// glitches shorter than the debounce time are not reported
+	for (int i = 0; i < 20; i++) {
+		set_pin(&port_e, PIN_A, 0);
+		ticks(3);
+		set_pin(&port_e, PIN_A, 1);
+		tick();
+	}
+	CHECK_EQ(event_count, 1);
+
+	set_pin(&port_e, PIN_A, 0);
+	debo_remove_pin(id);
+}
+
+/** Pins on one port with different debounce times change independently */
+static void test_mixed_times(void)
+{
+	reset_events();
+	debo_id_t a = add_pin(&port_e, PIN_A, 3, 1);
+	debo_id_t b = add_pin(&port_e, PIN_B, 10, 2);
+
+	set_pin(&port_e, PIN_A | PIN_B, 1);
+	ticks(12);
+
+	CHECK_EQ(event_count, 2);
+	CHECK_EQ(events[0].payload, 1);
+	CHECK_EQ(events[0].time, 4);
+	CHECK_EQ(events[1].payload, 2);
+	CHECK_EQ(events[1].time, 11);
+
+	// a glitch on B long enough for A doesn't disturb A's state
+	set_pin(&port_e, PIN_A | PIN_B, 0);
+	ticks(5);
+	set_pin(&port_e, PIN_B, 1);
+	ticks(20);
+	CHECK_EQ(event_count, 3);
+	CHECK_EQ(events[2].payload, 1);
+	CHECK_EQ(events[2].event, DEBO_EV_RELEASE);
+	CHECK(!debo_pin_state(a));
+	CHECK(debo_pin_state(b));
+
+	set_pin(&port_e, PIN_B, 0);
+	debo_remove_pin(a);
+	debo_remove_pin(b);
+}
+
+/** Inverted pins (buttons to ground) */
+static void test_invert(void)
+{
+	reset_events();
+	set_pin(&port_e, PIN_A, 1); // released
+
+	debo_init_t init;
+	memset(&init, 0, sizeof(init));
+	init.GPIOx = &port_e;
+	init.pin = PIN_A;
+	init.debo_time = 2;
+	init.invert = true;
+	init.cb_payload = 7;
+	init.callback = record_cb;
+	debo_id_t id = debo_register_pin(&init);
+
+	CHECK(!debo_pin_state(id));
+	set_pin(&port_e, PIN_A, 0);
+	ticks(3);
+	CHECK_EQ(event_count, 1);
+	CHECK_EQ(events[0].event, DEBO_EV_PRESS);
+	CHECK(debo_pin_state(id));
+
+	set_pin(&port_e, PIN_A, 1);
+	ticks(3);
+	debo_remove_pin(id);
+	set_pin(&port_e, PIN_A, 0);
+}
+
+/** Long press and hold-to-repeat */
+static void test_hold(void)
+{
+	reset_events();
+
+	debo_init_t init;
+	memset(&init, 0, sizeof(init));
+	init.GPIOx = &port_e;
+	init.pin = PIN_A;
+	init.debo_time = 1;
+	init.long_time = 50;
+	init.repeat_delay = 20;
+	init.repeat_interval = 10;
+	init.callback = record_cb;
+	debo_id_t id = debo_register_pin(&init);
+
+	set_pin(&port_e, PIN_A, 1);
+	ticks(2); // press at t=2
+	ticks(55);
+
+	// press @2 (held counts from 1), repeats @21, 31, 41, long @51, repeat @51
+	CHECK_EQ(event_count, 6);
+	CHECK_EQ(events[0].event, DEBO_EV_PRESS);
+	CHECK_EQ(events[1].event, DEBO_EV_REPEAT);
+	CHECK_EQ(events[1].time, 21);
+	CHECK_EQ(events[2].time, 31);
+	CHECK_EQ(events[3].time, 41);
+	CHECK_EQ(events[4].event, DEBO_EV_LONG);
+	CHECK_EQ(events[4].time, 51);
+	CHECK_EQ(events[5].event, DEBO_EV_REPEAT);
+
+	set_pin(&port_e, PIN_A, 0);
+	ticks(2);
+	CHECK_EQ(events[event_count - 1].event, DEBO_EV_RELEASE);
+	debo_remove_pin(id);
+}
+
+/** Ports are shared by their pins, released with the last one and reused */
+static void test_shared_ports(void)
+{
+	reset_events();
+
+	// 4 slots: port E twice, port D once
+	debo_id_t a = add_pin(&port_e, PIN_A, 1, 1);
+	debo_id_t b = add_pin(&port_e, PIN_B, 1, 2);
+	debo_id_t d = add_pin(&port_d, PIN_C, 1, 3);
+	debo_id_t a2 = add_pin(&port_e, PIN_A, 4, 4); // second slot on the same pin
+	CHECK(a && b && d && a2);
+
+	// all slots used
+	CHECK_EQ(add_pin(&port_c, PIN_C, 1, 5), DEBO_PIN_NONE);
+
+	// removing one of two slots on a pin keeps the pin sampled
+	CHECK(debo_remove_pin(a));
+	set_pin(&port_e, PIN_A, 1);
+	ticks(5);
+	CHECK_EQ(event_count, 1);
+	CHECK_EQ(events[0].payload, 4);
+	CHECK(debo_pin_state(a2));
+
+	// B still works on the shared port
+	set_pin(&port_e, PIN_B, 1);
+	ticks(2);
+	CHECK_EQ(event_count, 2);
+	CHECK_EQ(events[1].payload, 2);
+
+	// port D is independent
+	set_pin(&port_d, PIN_C, 1);
+	ticks(2);
+	CHECK_EQ(event_count, 3);
+	CHECK_EQ(events[2].payload, 3);
+
+	// release port E completely, a new port takes its group
+	CHECK(debo_remove_pin(b));
+	CHECK(debo_remove_pin(a2));
+	set_pin(&port_e, PIN_A | PIN_B, 0);
+
+	debo_id_t c = add_pin(&port_c, PIN_C, 1, 5);
+	CHECK(c != DEBO_PIN_NONE);
+	set_pin(&port_c, PIN_C, 1);
+	ticks(2);
+	CHECK_EQ(event_count, 4);
+	CHECK_EQ(events[3].payload, 5);
+
+	// port E is not sampled any more
+	set_pin(&port_e, PIN_A, 1);
+	ticks(10);
+	CHECK_EQ(event_count, 4);
+
+	debo_remove_pin(c);
+	debo_remove_pin(d);
+	set_pin(&port_e, PIN_A, 0);
+	set_pin(&port_d, PIN_C, 0);
+	set_pin(&port_c, PIN_C, 0);
+}
+
+int main(void)
+{
+	timebase_init(2, 2);
+	debounce_init(4);
+
+	test_clean_edge();
+	test_chatter();
+	test_mixed_times();
+	test_invert();
+	test_hold();
+	test_shared_ports();
+
+	return test_summary();
+}
@@ -0,0 +1,355 @@
+#include <string.h>
+#include <math.h>
+#include <stdlib.h>
+#include "test.h"
+#include "dsp.h"
+#include "fastlog.h"
+#include "bands.h"
+
+/**
+ * Golden vectors of the spectrum pipeline: dsp_spectrum() with each
+ * magnitude method, and fastlog on the results, for checked-in input
+ * frames (data/golden/<signal>_<len>.in) at every FFT size. The outputs
+ * are compared with data/golden/<signal>_<len>.golden, the band heights
+ * of the bands.c mapping with data/golden/<signal>_<len>.bands.
+ *
+ * After an intended change of the output, regenerate both with
+ *   test_golden --update
+ * (run in test/) and review the diff of the .golden files.
+ */
+
+#define SAMPLE_RATE 20000.0
+
+/** Spectrum gain of the FFT modes with the default scale (FFT_SCALE * y_scale in user_main.c) */
+#define BAND_GAIN (0.25 * 0.3 / 16 * 5)
+
+#define GOLDEN_DIR "data/golden/"
+
+/**
+ * Tolerance of the bins: 1e-5 of the frame's largest bin (-100 dB), which
+ * absorbs FMA contraction and other compiler differences but nothing an
+ * algorithm change would cause. AMBM rounds to an integer before the
+ * normalisation: plus 1.
+ */
+#define BIN_TOL 1e-5
+
+/**
+ * fastlog results may move by one step of its 64 entry mantissa table (up
+ * to 6 in Q8) where a bin within the tolerance crosses an entry boundary
+ */
+#define LOG_TOL 6
+
+/** ... compared only for bins above this fraction of the peak (the -60 dB log scale floor) */
+#define LOG_FLOOR 1e-3
+
+enum { COL_EXACT, COL_SQUARED, COL_AMBM, COL_LOG_SQUARED, COL_LOG_AMBM, COL_COUNT };
+
+/** Band heights: of the exact magnitudes, and the square root of the power bands like calculate_fft() */
+enum { BAND_EXACT, BAND_POWER, BAND_COL_COUNT };
+
+static const char *signals[] = {"sine", "chirp", "noise", "silence", "pink", "clipped"};
+#define SIGNAL_COUNT (sizeof(signals) / sizeof(signals[0]))
+
+static uint32_t input[FFT_MAX_LEN];
+static uint32_t buf[FFT_MAX_LEN * 2];
+static double result[FFT_MAX_LEN / 2][COL_COUNT];
+static double golden[FFT_MAX_LEN / 2][COL_COUNT];
+static float scaled[FFT_MAX_LEN / 2];
+static double band_result[BAND_COUNT][BAND_COL_COUNT];
+static double band_golden[BAND_COUNT][BAND_COL_COUNT];
+
+static uint32_t sample_word(double left, double right)
+{
+	const uint32_t l = (uint32_t) lround(32768 + left);
+	const uint32_t r = (uint32_t) lround(32768 + right);
+	return (l & 0xFFFF) | (r << 16);
+}
+
+/** Generate an input frame (--update only; the checks read the files) */
+static void generate(uint32_t signal, uint32_t len)
+{
+	uint32_t lcg = 1;
+	double pink[3] = {0};
+
+	for (uint32_t i = 0; i < len; i++) {
+		const double t = i / SAMPLE_RATE;
+		const double right = 9000 * sin(2 * M_PI * 300 * t); // must not show up
+		double left = 0;
+
+		switch (signal) {
+			case 0: // off the bin centres at every size
+				left = 20000 * sin(2 * M_PI * 1000 * t + 0.3);
+				break;
+
+			case 1: { // linear 50 Hz .. 9 kHz over the frame
+				const double span = len / SAMPLE_RATE;
+				const double k = (9000 - 50) / span;
+				left = 12000 * sin(2 * M_PI * (50 * t + 0.5 * k * t * t));
+				break;
+			}
+
+			case 2: // uniform +-8000
+				lcg = lcg * 1664525 + 1013904223;
+				left = 8000 * ((double) (lcg >> 8) / (1 << 23) - 1);
+				break;
+
+			case 3: // a DC offset only
+				left = 1500;
+				break;
+
+			case 4: { // -3 dB per octave: uniform noise through Paul Kellet's economy filter
+				lcg = lcg * 1664525 + 1013904223;
+				const double white = (double) (lcg >> 8) / (1 << 23) - 1;
+				pink[0] = 0.99765 * pink[0] + white * 0.0990460;
+				pink[1] = 0.96300 * pink[1] + white * 0.2965164;
+				pink[2] = 0.57000 * pink[2] + white * 1.0526913;
+				left = 3000 * (pink[0] + pink[1] + pink[2] + white * 0.1848);
+				break;
+			}
+
+			default: // a sine twice the full scale, saturated like an overdriven input
+				left = fmax(-32768, fmin(32767, 65000 * sin(2 * M_PI * 700 * t + 0.3)));
+				break;
+		}
+
+		input[i] = sample_word(left, right);
+	}
+}
+
+/** Run the pipeline on the input frame */
+static void compute(const fft_config_t *cfg)
+{
+	static const mag_method_t methods[] = {MAG_EXACT, MAG_SQUARED, MAG_AMBM};
+	const uint32_t bins = cfg->fft_len / 2;
+
+	for (uint32_t m = 0; m < 3; m++) {
+		memcpy(buf, input, cfg->fft_len * sizeof(uint32_t));
+		dsp_spectrum(buf, cfg, 1.0f, methods[m]);
+
+		const float *out = (const float *) buf;
+		for (uint32_t b = 0; b < bins; b++) {
+			result[b][m] = out[b];
+
+			if (methods[m] == MAG_SQUARED) result[b][COL_LOG_SQUARED] = fastlog2_f32(out[b]);
+			if (methods[m] == MAG_AMBM) result[b][COL_LOG_AMBM] = fastlog2_u32((uint32_t) out[b]);
+		}
+	}
+
+	// the band mapping, on the bins scaled like the FFT modes show them
+	float levels[BAND_COUNT];
+	bands_configure((float) SAMPLE_RATE, cfg->fft_len);
+
+	for (uint32_t b = 0; b < bins; b++) scaled[b] = (float) (result[b][COL_EXACT] * BAND_GAIN);
+	bands_compute(scaled, levels);
+	for (uint32_t i = 0; i < BAND_COUNT; i++) band_result[i][BAND_EXACT] = levels[i];
+
+	for (uint32_t b = 0; b < bins; b++) scaled[b] = (float) (result[b][COL_SQUARED] * BAND_GAIN * BAND_GAIN);
+	bands_compute(scaled, levels);
+	for (uint32_t i = 0; i < BAND_COUNT; i++) band_result[i][BAND_POWER] = sqrtf(levels[i]);
+}
+
+static void path(char *dest, size_t size, uint32_t signal, uint32_t len, const char *ext)
+{
+	snprintf(dest, size, GOLDEN_DIR "%s_%u.%s", signals[signal], (unsigned) len, ext);
+}
+
+static void write_files(uint32_t signal, uint32_t len)
+{
+	char name[64];
+
+	path(name, sizeof(name), signal, len, "in");
+	FILE *f = fopen(name, "w");
+	if (!f) { perror(name); exit(1); }
+	fprintf(f, "# %s, %u sample words (left | right << 16) at %.0f Hz\n", signals[signal], (unsigned) len, SAMPLE_RATE);
+	for (uint32_t i = 0; i < len; i++) fprintf(f, "%08x\n", (unsigned) input[i]);
+	fclose(f);
+
+	path(name, sizeof(name), signal, len, "golden");
+	f = fopen(name, "w");
+	if (!f) { perror(name); exit(1); }
+	fprintf(f, "# bin, exact, squared, ambm, fastlog2_f32(squared), fastlog2_u32(ambm)\n");
+	for (uint32_t b = 0; b < len / 2; b++) {
+		fprintf(f, "%u %.9g %.9g %.9g %.0f %.0f\n", (unsigned) b,
+				result[b][COL_EXACT], result[b][COL_SQUARED], result[b][COL_AMBM],
+				result[b][COL_LOG_SQUARED], result[b][COL_LOG_AMBM]);
+	}
+	fclose(f);
+
+	path(name, sizeof(name), signal, len, "bands");
+	f = fopen(name, "w");
+	if (!f) { perror(name); exit(1); }
+	fprintf(f, "# band, height from the exact bins, sqrt of the height from the squared bins (rows, default scale)\n");
+	for (uint32_t i = 0; i < BAND_COUNT; i++) {
+		fprintf(f, "%u %.9g %.9g\n", (unsigned) i, band_result[i][BAND_EXACT], band_result[i][BAND_POWER]);
+	}
+	fclose(f);
+}
+
+/** Read an input frame, false if missing or short */
+static bool read_input(uint32_t signal, uint32_t len)
+{
+	char name[64];
+	char line[128];
+	uint32_t n = 0;
+
+	path(name, sizeof(name), signal, len, "in");
+	FILE *f = fopen(name, "r");
+	if (!f) return false;
+
+	while (n < len && fgets(line, sizeof(line), f)) {
+		if (line[0] == '#') continue;
+		input[n++] = (uint32_t) strtoul(line, NULL, 16);
+	}
+	fclose(f);
+
+	return n == len;
+}
+
+/** Read the golden outputs, false if missing or short */
+static bool read_golden(uint32_t signal, uint32_t len)
+{
+	char name[64];
+	char line[256];
+	uint32_t n = 0;
+
+	path(name, sizeof(name), signal, len, "golden");
+	FILE *f = fopen(name, "r");
+	if (!f) return false;
+
+	while (n < len / 2 && fgets(line, sizeof(line), f)) {
+		if (line[0] == '#') continue;
+
+		unsigned bin;
+		double *g = golden[n];
+		if (sscanf(line, "%u %lf %lf %lf %lf %lf", &bin, &g[0], &g[1], &g[2], &g[3], &g[4]) != 6 || bin != n) break;
+		n++;
+	}
+	fclose(f);
+
+	return n == len / 2;
+}
+
+/** Read the golden band heights, false if missing or short */
+static bool read_bands(uint32_t signal, uint32_t len)
+{
+	char name[64];
+	char line[128];
+	uint32_t n = 0;
+
+	path(name, sizeof(name), signal, len, "bands");
+	FILE *f = fopen(name, "r");
+	if (!f) return false;
+
+	while (n < BAND_COUNT && fgets(line, sizeof(line), f)) {
+		if (line[0] == '#') continue;
+
+		unsigned band;
+		double *g = band_golden[n];
+		if (sscanf(line, "%u %lf %lf", &band, &g[0], &g[1]) != 3 || band != n) break;
+		n++;
+	}
+	fclose(f);
+
+	return n == BAND_COUNT;
+}
+
+/** Compare a frame's outputs, print the first mismatch of each column */
+static void compare(uint32_t signal, uint32_t len)
+{
+	const uint32_t bins = len / 2;
+	double peak[3] = {0};
+
+	for (uint32_t b = 0; b < bins; b++) {
+		for (int c = 0; c < 3; c++) {
+			if (golden[b][c] > peak[c]) peak[c] = golden[b][c];
+		}
+	}
+
+	for (int c = 0; c < COL_COUNT; c++) {
+		uint32_t mismatches = 0;
+
+		for (uint32_t b = 0; b < bins; b++) {
+			const double got = result[b][c], want = golden[b][c];
+			bool ok;
+
+			if (c < 3) {
+				const double tol = BIN_TOL * peak[c] + (c == COL_AMBM ? 1 : 0);
+				ok = fabs(got - want) <= tol;
+			} else {
+				// the log of the squared bins against the squared peak, AMBM against its own
+				const int src = c == COL_LOG_SQUARED ? COL_SQUARED : COL_AMBM;
+				const double floor = src == COL_SQUARED ? LOG_FLOOR * LOG_FLOOR : LOG_FLOOR;
+				ok = golden[b][src] < floor * peak[src] || fabs(got - want) <= LOG_TOL;
+			}
+
+			if (!ok && mismatches++ == 0) {
+				printf("%s_%u: bin %u column %d: %.9g, golden %.9g\n",
+					   signals[signal], (unsigned) len, (unsigned) b, c, got, want);
+			}
+		}
+
+		CHECK_EQ(mismatches, 0);
+	}
+}
+
+/** Compare the band heights, with the bins' tolerance of the highest band */
+static void compare_bands(uint32_t signal, uint32_t len)
+{
+	for (int c = 0; c < BAND_COL_COUNT; c++) {
+		double peak = 0;
+		for (uint32_t i = 0; i < BAND_COUNT; i++) {
+			if (band_golden[i][c] > peak) peak = band_golden[i][c];
+		}
+
+		uint32_t mismatches = 0;
+		for (uint32_t i = 0; i < BAND_COUNT; i++) {
+			const double got = band_result[i][c], want = band_golden[i][c];
+
+			if (fabs(got - want) > BIN_TOL * peak && mismatches++ == 0) {
+				printf("%s_%u: band %u column %d: %.9g, golden %.9g\n",
+					   signals[signal], (unsigned) len, (unsigned) i, c, got, want);
+			}
+		}
+
+		CHECK_EQ(mismatches, 0);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	const bool update = argc > 1 && strcmp(argv[1], "--update") == 0;
+
+	for (uint32_t s = 0; s < SIGNAL_COUNT; s++) {
+		for (uint32_t c = 0; c < FFT_CONFIG_COUNT; c++) {
+			const fft_config_t *cfg = fft_config_get(c);
+
+			if (update) {
+				generate(s, cfg->fft_len);
+				compute(cfg);
+				write_files(s, cfg->fft_len);
+				continue;
+			}
+
+			const bool have_input = read_input(s, cfg->fft_len);
+			CHECK(have_input);
+			if (!have_input) continue;
+
+			compute(cfg);
+
+			const bool have_golden = read_golden(s, cfg->fft_len);
+			CHECK(have_golden);
+			if (have_golden) compare(s, cfg->fft_len);
+
+			const bool have_bands = read_bands(s, cfg->fft_len);
+			CHECK(have_bands);
+			if (have_bands) compare_bands(s, cfg->fft_len);
+		}
+	}
+
+	if (update) {
+		printf("golden files written to " GOLDEN_DIR "\n");
+		return 0;
+	}
+
+	return test_summary();
+}
@@ -0,0 +1,125 @@
+#include <math.h>
+#include "test.h"
+#include "magnitude.h"
+
+// Error of the magnitude methods against sqrt(re^2 + im^2)
+
+/** Documented MAG_AMBM error range (magnitude.h) */
+#define AMBM_ERR_MIN -0.040
+#define AMBM_ERR_MAX 0.040
+
+/** Angle steps over the full circle */
+#define ANGLES 3600
+
+/** Interleaved complex values and the output */
+static float cplx[ANGLES * 2];
+static float out[ANGLES];
+
+static void fill_circle(double radius)
+{
+	for (uint32_t i = 0; i < ANGLES; i++) {
+		const double phi = 2 * M_PI * i / ANGLES;
+		cplx[i * 2] = (float) round(radius * cos(phi));
+		cplx[i * 2 + 1] = (float) round(radius * sin(phi));
+	}
+}
+
+/** Exact magnitude of the (integer) input value */
+static double exact(uint32_t i)
+{
+	return hypot(cplx[i * 2], cplx[i * 2 + 1]);
+}
+
+/**
+ * Sweep angles and magnitudes: the error stays in the documented range,
+ * and reaches close to both ends (the coefficients minimise the peak error).
+ * From 10^4 up the integer rounding of the input and output adds < 0.02 %.
+ */
+static void test_ambm_error(void)
+{
+	double err_min = 0, err_max = 0;
+
+	for (double radius = 1e4; radius < 2e9; radius *= 1.7) {
+		fill_circle(radius);
+		magnitude(cplx, out, ANGLES, MAG_AMBM);
+
+		for (uint32_t i = 0; i < ANGLES; i++) {
+			const double err = out[i] / exact(i) - 1;
+			if (err < err_min) err_min = err;
+			if (err > err_max) err_max = err;
+		}
+	}
+
+	printf("AMBM error %+.2f %% .. %+.2f %%\n", err_min * 100, err_max * 100);
+	CHECK(err_min >= AMBM_ERR_MIN);
+	CHECK(err_max <= AMBM_ERR_MAX);
+	CHECK(err_min < AMBM_ERR_MIN + 0.002);
+	CHECK(err_max > AMBM_ERR_MAX - 0.002);
+}
+
+/** The low extremes (-4 %) are on the axes and at 45 degrees, the same in every quadrant */
+static void test_ambm_axes(void)
+{
+	const float values[] = {
+		10000, 0,
+		0, -10000,
+		-10000, 0,
+		7071, 7071,
+	};
+	magnitude(values, out, 4, MAG_AMBM);
+
+	for (uint32_t i = 0; i < 4; i++) {
+		const double err = out[i] / hypot(values[i * 2], values[i * 2 + 1]) - 1;
+		CHECK(err >= AMBM_ERR_MIN && err <= AMBM_ERR_MAX);
+	}
+	CHECK_EQ(out[0], out[1]);
+	CHECK_EQ(out[0], out[2]);
+}
+
+/** Small values lose their fraction to the integer conversion, zero stays zero */
+static void test_ambm_small(void)
+{
+	const float values[] = {0, 0, 0.9f, -0.9f, 3, 4};
+	magnitude(values, out, 3, MAG_AMBM);
+
+	CHECK_EQ(out[0], 0);
+	CHECK_EQ(out[1], 0);
+	CHECK_NEAR(out[2], 5, 5 * AMBM_ERR_MAX + 1);
+}
+
+/** In place, like dsp_spectrum() uses it */
+static void test_in_place(void)
+{
+	fill_circle(1e5);
+	magnitude(cplx, out, ANGLES, MAG_AMBM);
+	magnitude(cplx, cplx, ANGLES, MAG_AMBM);
+
+	uint32_t mismatches = 0;
+	for (uint32_t i = 0; i < ANGLES; i++) {
+		if (cplx[i] != out[i]) mismatches++;
+	}
+	CHECK_EQ(mismatches, 0);
+}
+
+/** The exact and the squared methods against double precision */
+static void test_exact(void)
+{
+	fill_circle(12345.0);
+	magnitude(cplx, out, ANGLES, MAG_EXACT);
+	for (uint32_t i = 0; i < ANGLES; i += 7) CHECK_NEAR(out[i] / exact(i), 1.0, 1e-6);
+
+	fill_circle(12345.0);
+	magnitude(cplx, out, ANGLES, MAG_SQUARED);
+	for (uint32_t i = 0; i < ANGLES; i += 7) CHECK_NEAR(out[i] / (exact(i) * exact(i)), 1.0, 1e-6);
+}
+
+int main(void)
+{
+	test_ambm_error();
+	test_ambm_axes();
+	test_ambm_small();
+	test_in_place();
+	test_exact();
+
+	return test_summary();
+}
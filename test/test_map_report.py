@@ -0,0 +1,104 @@
+#!/usr/bin/env python3
+"""
+Host test of map_report.py on a map file excerpt (data/sample.map).
+"""
+
+import os
+import subprocess
+import sys
+import tempfile
+import unittest
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+SCRIPT = os.path.join(HERE, '..', 'map_report.py')
+SAMPLE = os.path.join(HERE, 'data', 'sample.map')
+
+sys.path.insert(0, os.path.dirname(SCRIPT))
+import map_report  # noqa: E402
+
+
+def run(*args):
+    return subprocess.run([sys.executable, SCRIPT, SAMPLE] + list(args),
+                          stdout=subprocess.PIPE, stderr=subprocess.PIPE, universal_newlines=True)
+
+
+class MapReportTest(unittest.TestCase):
+    def setUp(self):
+        self.tmp = tempfile.TemporaryDirectory()
+        self.budget = os.path.join(self.tmp.name, 'mem_budget.txt')
+
+    def tearDown(self):
+        self.tmp.cleanup()
+
+    def test_parse(self):
+        modules = map_report.parse_map(SAMPLE)
+        self.assertEqual(modules['decimator.c'], [0x60 + 0xc, 0xc])  # .ramfunc is in .data
+        self.assertEqual(modules['dotmatrix.c'], [0x60, 0])          # long and short section lines
+        self.assertEqual(modules['user_main.c'], [0x60 + 0x4, 0x4 + 0x2000 + 0x10])
+        self.assertEqual(modules['libCMSIS.a'], [0x400 + 0x40, 0x40])     # moved to .data
+        self.assertEqual(modules['libgcc.a'], [0x80, 0])
+        self.assertNotIn('.comment', modules)
+
+    def test_ram_code(self):
+        code = map_report.parse_ram_code(SAMPLE)
+        self.assertEqual(code, {'decimator.c': 0xc, 'libCMSIS.a': 0x40})  # not the .data variables
+
+        r = run()
+        self.assertIn('Code run from RAM', r.stdout)
+
+    def test_ram_objects(self):
+        self.assertEqual(map_report.object_name('libCMSIS.a(arm_cfft_f32.c.obj)'), 'arm_cfft_f32.c')
+        self.assertEqual(map_report.object_name('CMakeFiles/x.dir/User/dsp.c.o'), 'dsp.c')
+
+        self.assertEqual(map_report.check_ram_objects(SAMPLE, ['arm_cfft_radix8_f32.c']), [])
+        errors = map_report.check_ram_objects(SAMPLE, ['arm_cfft_f32.c', '_arm_addsubsf3', '_arm_muldivsf3'])
+        self.assertEqual(len(errors), 3)
+        self.assertIn('arm_cfft_f32.c: code in flash', errors[0])
+        self.assertIn('_arm_addsubsf3: code in flash', errors[1])
+        self.assertIn('_arm_muldivsf3: no code in .data', errors[2])
+
+        self.assertEqual(run('--ram-objects', 'arm_cfft_radix8_f32.c').returncode, 0)
+        r = run('--ram-objects', 'arm_cfft_radix8_f32.c', 'arm_cfft_f32.c')
+        self.assertEqual(r.returncode, 1)
+        self.assertIn('arm_cfft_f32.c: code in flash', r.stderr)
+
+    def test_save_and_check(self):
+        self.assertEqual(run('--save', self.budget).returncode, 0)
+        self.assertEqual(run('--check', self.budget).returncode, 0)
+
+    def test_growth_fails(self):
+        modules = map_report.parse_map(SAMPLE)
+        modules['user_main.c'][1] -= 2000  # baseline 2000 bytes smaller
+        map_report.save_budget(self.budget, modules)
+
+        r = run('--check', self.budget)
+        self.assertEqual(r.returncode, 1)
+        self.assertIn('user_main.c: RAM grew', r.stderr)
+
+    def test_small_growth_passes(self):
+        modules = map_report.parse_map(SAMPLE)
+        modules['dotmatrix.c'][0] -= 60  # under the 64 byte minimum margin
+        map_report.save_budget(self.budget, modules)
+        self.assertEqual(run('--check', self.budget).returncode, 0)
+
+    def test_missing_baseline(self):
+        r = run('--check', self.budget)
+        self.assertEqual(r.returncode, 0)
+        self.assertIn('warning: no baseline', r.stderr)
+
+        r = run('--check', self.budget, '--require-baseline')
+        self.assertEqual(r.returncode, 1)
+        self.assertIn('error: no baseline', r.stderr)
+
+    def test_new_module_warns(self):
+        modules = map_report.parse_map(SAMPLE)
+        del modules['font.c']
+        map_report.save_budget(self.budget, modules)
+
+        r = run('--check', self.budget)
+        self.assertEqual(r.returncode, 0)
+        self.assertIn('font.c is not in the baseline', r.stderr)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,169 @@
+#include <string.h>
+#include "test.h"
+#include "max2719.h"
+#include "spi_emu.h"
+
+// MAX2719 chain writes through the register-level SPI stand-in
+
+#define CS_PIN (1 << 4)
+
+static MAX2719_Cfg make_chain(uint32_t chain_len)
+{
+	MAX2719_Cfg inst;
+	memset(&inst, 0, sizeof(inst));
+	inst.SPIx = spi_emu_spi();
+	inst.CS_GPIOx = spi_emu_gpio();
+	inst.CS_PINx = CS_PIN;
+	inst.chain_len = chain_len;
+	return inst;
+}
+
+static uint16_t word(MAX2719_Command cmd, uint8_t data)
+{
+	return (uint16_t) ((cmd << 8) | data);
+}
+
+/** One CS low period with `frames` frames, all sent with CS low, nothing left in the shifter */
+static void check_framing(uint32_t transfers, uint32_t frames)
+{
+	const spi_emu_log_t *log = spi_emu_log();
+
+	CHECK_EQ(log->cs_count, transfers);
+	CHECK_EQ(log->word_count, transfers * frames);
+	for (uint32_t i = 0; i < log->cs_count; i++) {
+		CHECK_EQ(log->cs_frames[i], frames);
+	}
+	for (uint32_t i = 0; i < log->word_count; i++) {
+		CHECK(log->words_cs_low[i]);
+	}
+
+	CHECK_EQ(log->overruns, 0);
+	CHECK_EQ(log->disabled_writes, 0);
+	CHECK_EQ(log->cs_glitches, 0);
+	CHECK(!spi_emu_cs_low());
+	CHECK(spi_emu_idle());
+}
+
+/** HAL_SPI_Init() leaves SPE off, the driver enables it before the first frame */
+static void test_enables_spi(void)
+{
+	spi_emu_init();
+	MAX2719_Cfg inst = make_chain(2);
+
+	max2719_cmd_all(&inst, MAX2719_CMD_SHUTDOWN, 0x01);
+	check_framing(1, 2);
+	CHECK(inst.SPIx->CR1 & SPI_CR1_SPE);
+}
+
+static void test_cmd_all(void)
+{
+	spi_emu_init();
+	MAX2719_Cfg inst = make_chain(8);
+
+	max2719_cmd_all(&inst, MAX2719_CMD_INTENSITY, 0x07);
+	check_framing(1, 8);
+
+	const spi_emu_log_t *log = spi_emu_log();
+	for (uint32_t i = 0; i < 8; i++) {
+		CHECK_EQ(log->words[i], word(MAX2719_CMD_INTENSITY, 0x07));
+	}
+}
+
+/** The last driver's word goes first, the others get a no-op */
+static void test_cmd_nth(void)
+{
+	spi_emu_init();
+	MAX2719_Cfg inst = make_chain(4);
+
+	for (uint32_t nth = 0; nth < 4; nth++) {
+		spi_emu_clear();
+		max2719_cmd(&inst, nth, MAX2719_CMD_DIGIT3, (uint8_t) (0xA0 + nth));
+		check_framing(1, 4);
+
+		const spi_emu_log_t *log = spi_emu_log();
+		for (uint32_t i = 0; i < 4; i++) {
+			if (i == 3 - nth) {
+				CHECK_EQ(log->words[i], word(MAX2719_CMD_DIGIT3, (uint8_t) (0xA0 + nth)));
+			} else {
+				CHECK_EQ(log->words[i], word(MAX2719_CMD_NOOP, 0));
+			}
+		}
+	}
+}
+
+static void test_cmd_all_data(void)
+{
+	spi_emu_init();
+	MAX2719_Cfg inst = make_chain(8);
+	uint8_t data[8] = {0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80};
+
+	max2719_cmd_all_data(&inst, MAX2719_CMD_DIGIT0, data);
+	check_framing(1, 8);
+
+	const spi_emu_log_t *log = spi_emu_log();
+	for (uint32_t i = 0; i < 8; i++) {
+		CHECK_EQ(log->words[i], word(MAX2719_CMD_DIGIT0, data[7 - i]));
+	}
+}
+
+/** Back-to-back writes each get their own CS period, like a display refresh */
+static void test_back_to_back(void)
+{
+	spi_emu_init();
+	MAX2719_Cfg inst = make_chain(8);
+	uint8_t data[8];
+
+	for (uint32_t d = 0; d < 8; d++) {
+		memset(data, (int) (1 << d), sizeof(data));
+		max2719_cmd_all_data(&inst, MAX2719_CMD_DIGIT0 + d, data);
+	}
+	check_framing(8, 8);
+
+	const spi_emu_log_t *log = spi_emu_log();
+	CHECK_EQ(log->words[0], word(MAX2719_CMD_DIGIT0, 0x01));
+	CHECK_EQ(log->words[63], word(MAX2719_CMD_DIGIT7, 0x80));
+}
+
+static void test_single_driver(void)
+{
+	spi_emu_init();
+	MAX2719_Cfg inst = make_chain(1);
+
+	max2719_cmd(&inst, 0, MAX2719_CMD_SCAN_LIMIT, 0x07);
+	check_framing(1, 1);
+	CHECK_EQ(spi_emu_log()->words[0], word(MAX2719_CMD_SCAN_LIMIT, 0x07));
+}
+
+/** The stand-in itself: a sender that skips the TXE and BSY waits is caught */
+static void test_catches_bad_sender(void)
+{
+	spi_emu_init();
+	SPI_TypeDef *spi = spi_emu_spi();
+	GPIO_TypeDef *gpio = spi_emu_gpio();
+
+	spi->DR = 0x0101;
+	CHECK_EQ(spi_emu_log()->disabled_writes, 1);
+
+	spi->CR1 |= SPI_CR1_SPE;
+	gpio->BRR = CS_PIN;
+	spi->DR = 0x0101;
+	spi->DR = 0x0202;
+	spi->DR = 0x0303;
+	gpio->BSRR = CS_PIN;
+
+	CHECK_EQ(spi_emu_log()->overruns, 1);
+	CHECK_EQ(spi_emu_log()->cs_glitches, 1);
+}
+
+int main(void)
+{
+	test_enables_spi();
+	test_cmd_all();
+	test_cmd_nth();
+	test_cmd_all_data();
+	test_back_to_back();
+	test_single_driver();
+	test_catches_bad_sender();
+
+	return test_summary();
+}
@@ -0,0 +1,202 @@
+#include <string.h>
+#include <math.h>
+#include "test.h"
+#include "dsp.h"
+#include "bands.h"
+#include "onset.h"
+#include "drum_synth.h"
+
+// Onset detection on labelled drum loops, frames timed by the sample clock
+
+#define SAMPLE_RATE 20000.0f
+#define DURATION_MS 8000
+#define TOTAL 160000 // SAMPLE_RATE * DURATION_MS
+
+/** Spectrum gain of the beat mode (FFT_SCALE * default y_scale in user_main.c) */
+#define GAIN (0.25f * 0.3f / 16 * 5)
+
+/** A detection may come this late after the frame holding the onset (ms) */
+#define LATE_MS 50
+
+#define MAX_ONSETS 256
+
+static uint32_t audio[TOTAL];
+static uint32_t frame[FFT_MAX_LEN * 2];
+
+/**
+ * Samples missed between frames while the last one renders. The capture
+ * restarts after the render, so the gaps vary; the sample clock counts them.
+ */
+static uint32_t gap_samples(uint32_t frame_index)
+{
+	return (frame_index * 37) % 61;
+}
+
+/** Band levels of a frame, like calculate_fft() */
+static void frame_levels(const uint32_t *samples, const fft_config_t *cfg, float *levels)
+{
+	memcpy(frame, samples, cfg->fft_len * sizeof(uint32_t));
+	dsp_spectrum(frame, cfg, GAIN, MAG_SQUARED);
+	bands_compute((const float *) frame, levels);
+
+	for (int b = 0; b < BAND_COUNT; b++) {
+		levels[b] = sqrtf(levels[b]);
+	}
+}
+
+/**
+ * @brief Run the detector over the rendered audio
+ * @return number of detections, their times in `detected`
+ */
+static uint32_t detect(const fft_config_t *cfg, float *detected)
+{
+	float levels[BAND_COUNT];
+	uint32_t n = 0;
+
+	onset_reset();
+	bands_configure(SAMPLE_RATE, cfg->fft_len);
+
+	uint32_t pos = 0;
+	for (uint32_t f = 0; pos + cfg->fft_len <= TOTAL; f++) {
+		frame_levels(audio + pos, cfg, levels);
+		pos += cfg->fft_len;
+
+		// the sample clock at the frame's last sample
+		const ms_time_t now = (ms_time_t) (pos * 1000.0f / SAMPLE_RATE);
+		if (onset_process(levels, now) && n < MAX_ONSETS) {
+			detected[n++] = (float) onset_last_time();
+		}
+
+		pos += gap_samples(f);
+	}
+
+	return n;
+}
+
+/**
+ * @brief Match detections to labels, one to one, in time order
+ * @return number of matched labels
+ */
+static uint32_t match(const float *labels, uint32_t label_count, const float *detected, uint32_t det_count, float frame_ms)
+{
+	uint32_t matched = 0;
+	uint32_t d = 0;
+
+	for (uint32_t l = 0; l < label_count; l++) {
+		// skip detections before this label's window; timestamps are whole ms
+		while (d < det_count && detected[d] < labels[l] - 1) d++;
+
+		if (d < det_count && detected[d] <= labels[l] + frame_ms + LATE_MS) {
+			matched++;
+			d++;
+		}
+	}
+
+	return matched;
+}
+
+/**
+ * Every hit at 64..256 points. At 512 and 1024 a frame is 26..51 ms long,
+ * a 20 ms hat adds too little to the frame's band levels to stand out next
+ * to the kicks; only the kick and snare hits are required there. At 1024 a
+ * kick two 16ths after another one still has the first one's tail in its
+ * frame and rises too little: a few are lost in the rock and backbeat loops.
+ */
+static void test_loops(void)
+{
+	static float all[MAX_ONSETS];
+	static float accents[MAX_ONSETS];
+	static float detected[MAX_ONSETS];
+
+	for (uint32_t i = 0; i < drum_loop_count; i++) {
+		const drum_loop_t *loop = &drum_loops[i];
+		drum_render(loop, SAMPLE_RATE, audio, TOTAL);
+		const uint32_t all_count = drum_onsets(loop, "ksh", DURATION_MS, all, MAX_ONSETS);
+		const uint32_t accent_count = drum_onsets(loop, "ks", DURATION_MS, accents, MAX_ONSETS);
+
+		for (uint32_t c = 0; c < FFT_CONFIG_COUNT; c++) {
+			const fft_config_t *cfg = fft_config_get(c);
+			const float frame_ms = cfg->fft_len * 1000.0f / SAMPLE_RATE;
+
+			const uint32_t det_count = detect(cfg, detected);
+			const uint32_t all_matched = match(all, all_count, detected, det_count, frame_ms);
+			const uint32_t accents_matched = match(accents, accent_count, detected, det_count, frame_ms);
+
+			const float recall = (float) all_matched / all_count;
+			const float accent_recall = (float) accents_matched / accent_count;
+			const float precision = det_count ? (float) all_matched / det_count : 0;
+
+			printf("%-18s %4u: %3u hits, %3u detected, recall %.2f, kick/snare %.2f, precision %.2f\n",
+				   loop->name, cfg->fft_len, (unsigned) all_count, (unsigned) det_count,
+				   recall, accent_recall, precision);
+
+			if (cfg->fft_len <= 256) CHECK(recall >= 0.9f);
+			CHECK(accent_recall >= (cfg->fft_len < 1024 ? 0.9f : 0.85f));
+			CHECK(precision >= 0.95f);
+		}
+	}
+}
+
+/** Steady sound and silence give no onsets; a loud tone ripples a little from frame to frame */
+static void test_no_onsets(void)
+{
+	float levels[BAND_COUNT];
+	const fft_config_t *cfg = fft_config_get(FFT_CONFIG_DEFAULT);
+
+	// a 440 Hz tone, half scale, after 0.5 s of silence
+	for (uint32_t i = 0; i < TOTAL; i++) {
+		long v = lround(32768 + 16000 * sin(2 * M_PI * 440 * i / SAMPLE_RATE));
+		audio[i] = (i < TOTAL / 16) ? 32768 : (uint32_t) v;
+	}
+
+	onset_reset();
+	bands_configure(SAMPLE_RATE, cfg->fft_len);
+	uint32_t pos = 0;
+	for (uint32_t f = 0; pos + cfg->fft_len <= TOTAL; f++, pos += cfg->fft_len) {
+		frame_levels(audio + pos, cfg, levels);
+		onset_process(levels, (ms_time_t) ((pos + cfg->fft_len) * 1000.0f / SAMPLE_RATE));
+	}
+	CHECK_EQ(onset_count(), 1); // the start of the tone
+
+	onset_reset();
+	for (uint32_t i = 0; i < TOTAL; i++) audio[i] = 32768;
+	for (uint32_t f = 0, pos = 0; pos + cfg->fft_len <= TOTAL; f++, pos += cfg->fft_len) {
+		frame_levels(audio + pos, cfg, levels);
+		onset_process(levels, (ms_time_t) ((pos + cfg->fft_len) * 1000.0f / SAMPLE_RATE));
+	}
+	CHECK_EQ(onset_count(), 0);
+}
+
+/** Onsets closer than the refractory time are merged */
+static void test_refractory(void)
+{
+	float quiet[BAND_COUNT] = {0};
+	float loud[BAND_COUNT];
+	for (int b = 0; b < BAND_COUNT; b++) loud[b] = 100;
+
+	onset_reset();
+	ms_time_t t = 1000;
+	for (int i = 0; i < 20; i++, t += 10) onset_process(quiet, t);
+
+	CHECK(onset_process(loud, t));
+	t += 10;
+	onset_process(quiet, t);
+	t += 10;
+	CHECK(!onset_process(loud, t)); // 20 ms later
+	CHECK_EQ(onset_count(), 1);
+
+	t += ONSET_REFRACTORY;
+	onset_process(quiet, t);
+	t += 10;
+	CHECK(onset_process(loud, t));
+	CHECK_EQ(onset_count(), 2);
+}
+
+int main(void)
+{
+	test_loops();
+	test_no_onsets();
+	test_refractory();
+
+	return test_summary();
+}
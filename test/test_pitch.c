@@ -0,0 +1,211 @@
+#include <math.h>
+#include "test.h"
+#include "pitch.h"
+#include "wav.h"
+
+// YIN pitch estimate on tones, at the capture rates and frame sizes, and on a recorded string
+
+/**
+ * Recorded plucked string (pluck-pcm16.wav of the CPython test suite),
+ * 0.3 s at 11025 Hz: middle C, on both channels. The string starts sharp
+ * and sags as it decays (up to 15 cents off), so the cents are checked
+ * against a reference for each frame.
+ */
+#define PLUCK_WAV "data/pluck.wav"
+#define PLUCK_NOTE 60 // C4, MIDI number
+
+/** The first frames hold the attack of the pluck, without a steady period */
+#define PLUCK_ATTACK 256
+
+/** Allowed error (cents); the tuner needle spans +-50 */
+#define CENTS_TOL 5.0
+
+static float samples[PITCH_MAX_LEN];
+
+static double cents(double freq, double ref)
+{
+	return 1200 * log2(freq / ref);
+}
+
+static void fill_sine(uint32_t n, double rate, double freq, double amplitude)
+{
+	for (uint32_t i = 0; i < n; i++) {
+		samples[i] = (float) (amplitude * sin(2 * M_PI * freq * i / rate));
+	}
+}
+
+/** Sines across the range, at the lowest, default and highest capture rates */
+static void test_sines(void)
+{
+	static const double rates[] = {8000, 20000, 44100};
+	static const double freqs[] = {55, 82.4, 110, 196, 261.6, 440, 659.3, 880, 1174.7};
+
+	for (uint32_t r = 0; r < sizeof(rates) / sizeof(rates[0]); r++) {
+		for (uint32_t f = 0; f < sizeof(freqs) / sizeof(freqs[0]); f++) {
+			// two periods must fit the decimated frame
+			if (2 * rates[r] / freqs[f] > PITCH_MAX_LEN) continue;
+
+			fill_sine(PITCH_MAX_LEN, rates[r], freqs[f], 8000);
+			const float est = pitch_detect(samples, PITCH_MAX_LEN, (float) rates[r]);
+
+			CHECK(est > 0);
+			if (est > 0) CHECK_NEAR(cents(est, freqs[f]), 0, CENTS_TOL);
+		}
+	}
+}
+
+/** A harmonic-rich tone (a string: fundamental plus decaying harmonics) gives the fundamental */
+static void test_harmonics(void)
+{
+	const double rate = 20000, freq = 110;
+
+	for (uint32_t i = 0; i < PITCH_MAX_LEN; i++) {
+		double v = 0;
+		for (int h = 1; h <= 8; h++) {
+			v += 6000.0 / h * sin(2 * M_PI * freq * h * i / rate + h);
+		}
+		samples[i] = (float) v;
+	}
+
+	const float est = pitch_detect(samples, PITCH_MAX_LEN, (float) rate);
+	CHECK_NEAR(cents(est, freq), 0, CENTS_TOL);
+}
+
+/**
+ * Full scale square wave: the decimated samples swing -32768..32767, the
+ * sample differences reach 65535 and their squares overflow 31 bits.
+ */
+static void test_full_scale(void)
+{
+	const double rate = 20000, freq = 220;
+
+	for (uint32_t i = 0; i < PITCH_MAX_LEN; i++) {
+		samples[i] = fmod(freq * i / rate, 1.0) < 0.5 ? 32767.0f : -32768.0f;
+	}
+
+	const float est = pitch_detect(samples, PITCH_MAX_LEN, (float) rate);
+	CHECK_NEAR(cents(est, freq), 0, CENTS_TOL);
+}
+
+/** Shorter frames still work down to two periods */
+static void test_frame_sizes(void)
+{
+	const double rate = 20000;
+
+	for (uint32_t len = 256; len <= PITCH_MAX_LEN; len *= 2) {
+		const double freq = 3 * rate / len; // three periods
+		fill_sine(len, rate, freq, 8000);
+
+		const float est = pitch_detect(samples, len, (float) rate);
+		CHECK_NEAR(cents(est, freq), 0, CENTS_TOL);
+	}
+}
+
+/** Silence, a quiet tone under the level gate and noise give no pitch */
+static void test_no_pitch(void)
+{
+	for (uint32_t i = 0; i < PITCH_MAX_LEN; i++) samples[i] = 0;
+	CHECK_EQ(pitch_detect(samples, PITCH_MAX_LEN, 20000), 0);
+
+	fill_sine(PITCH_MAX_LEN, 20000, 440, PITCH_MIN_RMS / 2);
+	CHECK_EQ(pitch_detect(samples, PITCH_MAX_LEN, 20000), 0);
+
+	uint32_t lcg = 1;
+	for (uint32_t i = 0; i < PITCH_MAX_LEN; i++) {
+		lcg = lcg * 1664525 + 1013904223;
+		samples[i] = (float) ((int32_t) lcg >> 17); // white noise, +-16384
+	}
+	CHECK_EQ(pitch_detect(samples, PITCH_MAX_LEN, 20000), 0);
+}
+
+/** Note and cents like display_tuner() shows them */
+static void tuner_note(float freq, int *note, float *cents)
+{
+	const float midi = 69 + 12 * log2f(freq / 440.0f);
+	*note = (int) roundf(midi);
+	*cents = (midi - *note) * 100;
+}
+
+/**
+ * Reference frequency of a frame around the expected note: the lag with
+ * the least squared difference, at the full rate in steps of 0.01 sample
+ * with linear interpolation. Slow, but independent of the decimation
+ * and the integer arithmetic of pitch_detect().
+ */
+static float reference_freq(uint32_t n, float rate, float freq)
+{
+	const uint32_t span = n - (uint32_t) (rate / freq * 1.1f) - 2;
+	float best_lag = 0;
+	double best = INFINITY;
+
+	for (float lag = rate / freq * 0.9f; lag < rate / freq * 1.1f; lag += 0.01f) {
+		const uint32_t k = (uint32_t) lag;
+		const float frac = lag - k;
+		double sum = 0;
+
+		for (uint32_t i = 0; i < span; i++) {
+			const float delayed = samples[i + k] + (samples[i + k + 1] - samples[i + k]) * frac;
+			sum += (samples[i] - delayed) * (samples[i] - delayed);
+		}
+
+		if (sum < best) {
+			best = sum;
+			best_lag = lag;
+		}
+	}
+
+	return rate / best_lag;
+}
+
+/** The recording in tuner frames, on both channels */
+static void test_recorded(void)
+{
+	const double c4 = 440 * pow(2, (PLUCK_NOTE - 69) / 12.0);
+
+	wav_t wav;
+	CHECK(wav_read(PLUCK_WAV, &wav));
+	if (!wav.count) return;
+
+	for (uint32_t ch = 0; ch < 2; ch++) {
+		for (uint32_t pos = 0; pos + PITCH_MAX_LEN <= wav.count; pos += PITCH_MAX_LEN / 4) {
+			float mean = 0;
+			for (uint32_t i = 0; i < PITCH_MAX_LEN; i++) {
+				samples[i] = (float) ((wav.words[pos + i] >> (ch * 16)) & 0xFFFF);
+				mean += samples[i];
+			}
+			mean /= PITCH_MAX_LEN;
+			for (uint32_t i = 0; i < PITCH_MAX_LEN; i++) samples[i] -= mean;
+
+			const float est = pitch_detect(samples, PITCH_MAX_LEN, (float) wav.rate);
+			CHECK(est > 0); // the string rings through the whole recording
+			if (est <= 0) continue;
+
+			int note, ref_note;
+			float est_cents, ref_cents;
+			tuner_note(est, &note, &est_cents);
+			tuner_note(reference_freq(PITCH_MAX_LEN, (float) wav.rate, (float) c4), &ref_note, &ref_cents);
+
+			printf("pluck ch %u at %4u: note %d %+5.1f cents, reference %d %+5.1f\n",
+				   (unsigned) ch, (unsigned) pos, note, est_cents, ref_note, ref_cents);
+			CHECK_EQ(note, PLUCK_NOTE);
+			CHECK_EQ(ref_note, PLUCK_NOTE);
+			if (pos >= PLUCK_ATTACK) CHECK_NEAR(est_cents, ref_cents, CENTS_TOL);
+		}
+	}
+
+	wav_free(&wav);
+}
+
+int main(void)
+{
+	pitch_init();
+
+	test_sines();
+	test_harmonics();
+	test_full_scale();
+	test_frame_sizes();
+	test_no_pitch();
+	test_recorded();
+
+	return test_summary();
+}
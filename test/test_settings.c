@@ -0,0 +1,291 @@
+#include <string.h>
+#include "test.h"
+#include "settings.h"
+#include "timebase.h"
+#include "stm32f1xx_hal.h"
+#include "flash_emu.h"
+
+// Settings store on the RAM Flash emulator, with power loss at every step of a save
+
+/** Record size in Flash (settings_record_t) */
+#define RECORD_SIZE 16
+#define RECORDS_PER_PAGE (FLASH_PAGE_SIZE / RECORD_SIZE)
+
+/** Halfwords programmed per record, the CRC is the last one */
+#define RECORD_HALFWORDS 7
+
+static settings_t make_values(uint32_t n)
+{
+	settings_t v;
+	memset(&v, 0, sizeof(v));
+	v.y_scale = (float) n;
+	v.brightness = (uint8_t) (n & 15);
+	v.render_mode = (uint8_t) (n % 9);
+	v.capture_preset = (uint8_t) (n % 11);
+	v.fft_size = n % 5;
+	v.db_scale = n & 1;
+	return v;
+}
+
+static bool same(const settings_t *a, const settings_t *b)
+{
+	return memcmp(a, b, sizeof(settings_t)) == 0;
+}
+
+static void advance_ms(uint32_t ms)
+{
+	while (ms--) timebase_ms_cb();
+}
+
+/** Change the settings and let the deferred save run */
+static void save(const settings_t *v)
+{
+	settings_changed(v);
+	advance_ms(SETTINGS_SAVE_DELAY);
+	settings_periodic();
+}
+
+/** Reboot: power on and scan the Flash */
+static bool boot(settings_t *out)
+{
+	flash_emu_power_on();
+	memset(out, 0, sizeof(*out));
+	return settings_load(out);
+}
+
+/** Number of slots that are not erased */
+static uint32_t used_slots(int page)
+{
+	const uint8_t *p = flash_emu_page(page);
+	uint32_t used = 0;
+
+	for (uint32_t i = 0; i < RECORDS_PER_PAGE; i++) {
+		for (uint32_t b = 0; b < RECORD_SIZE; b++) {
+			if (p[i * RECORD_SIZE + b] != 0xFF) {
+				used++;
+				break;
+			}
+		}
+	}
+
+	return used;
+}
+
+static void test_empty(void)
+{
+	flash_emu_init();
+	settings_t out;
+	CHECK(!boot(&out));
+}
+
+static void test_deferred_save(void)
+{
+	flash_emu_init();
+	settings_t out;
+	boot(&out);
+
+	settings_t a = make_values(1);
+	settings_changed(&a);
+	advance_ms(SETTINGS_SAVE_DELAY - 1);
+	settings_periodic();
+	CHECK_EQ(used_slots(0), 0);
+
+	// a change restarts the delay
+	settings_t b = make_values(2);
+	settings_changed(&b);
+	advance_ms(SETTINGS_SAVE_DELAY - 1);
+	settings_periodic();
+	CHECK_EQ(used_slots(0), 0);
+
+	advance_ms(1);
+	settings_periodic();
+	CHECK_EQ(used_slots(0), 1);
+
+	CHECK(boot(&out));
+	CHECK(same(&out, &b));
+
+	// unchanged values are not written again
+	save(&b);
+	CHECK_EQ(used_slots(0), 1);
+}
+
+/** Power lost after each halfword of a record, the old record survives */
+static void test_torn_record(void)
+{
+	for (uint32_t k = 0; k < RECORD_HALFWORDS; k++) {
+		flash_emu_init();
+		settings_t out;
+		boot(&out);
+
+		settings_t a = make_values(10);
+		save(&a);
+
+		settings_t b = make_values(11);
+		flash_emu_power_loss_after(k);
+		save(&b);
+		CHECK(flash_emu_power_lost());
+
+		CHECK(boot(&out));
+		CHECK(same(&out, &a));
+
+		// the torn slot is skipped, the next save goes after it
+		settings_t c = make_values(12);
+		save(&c);
+		CHECK(boot(&out));
+		CHECK(same(&out, &c));
+		CHECK_EQ(used_slots(0), (k == 0) ? 2 : 3);
+	}
+}
+
+/** Fill both pages, the next save erases the older one */
+static void test_both_pages_full(void)
+{
+	flash_emu_init();
+	settings_t out;
+	boot(&out);
+
+	uint32_t n;
+	for (n = 0; n < 2 * RECORDS_PER_PAGE; n++) {
+		settings_t v = make_values(n + 100);
+		save(&v);
+	}
+	CHECK_EQ(used_slots(0), RECORDS_PER_PAGE);
+	CHECK_EQ(used_slots(1), RECORDS_PER_PAGE);
+	CHECK_EQ(flash_emu_erase_count(0), 0);
+
+	settings_t last = make_values(n + 99);
+	CHECK(boot(&out));
+	CHECK(same(&out, &last));
+
+	settings_t v = make_values(n + 100);
+	save(&v);
+	CHECK_EQ(flash_emu_erase_count(0), 1);
+	CHECK_EQ(used_slots(0), 1);
+	CHECK(boot(&out));
+	CHECK(same(&out, &v));
+}
+
+/** Power lost in the middle of the page erase during a rotation */
+static void test_torn_erase(void)
+{
+	flash_emu_init();
+	settings_t out;
+	boot(&out);
+
+	uint32_t n;
+	for (n = 0; n < 2 * RECORDS_PER_PAGE; n++) {
+		settings_t v = make_values(n + 200);
+		save(&v);
+	}
+	settings_t last = make_values(n + 199);
+
+	// half of page 0 is erased, the rest holds older records
+	settings_t v = make_values(n + 200);
+	flash_emu_power_loss_in_erase();
+	save(&v);
+	CHECK(flash_emu_power_lost());
+	CHECK_EQ(used_slots(0), RECORDS_PER_PAGE / 2);
+
+	CHECK(boot(&out));
+	CHECK(same(&out, &last));
+
+	// the next save erases the page again
+	save(&v);
+	CHECK_EQ(flash_emu_erase_count(0), 1);
+	CHECK_EQ(used_slots(0), 1);
+	CHECK(boot(&out));
+	CHECK(same(&out, &v));
+}
+
+/** The 16-bit sequence number wraps, the newest record still wins */
+static void test_seq_wrap(void)
+{
+	flash_emu_init();
+	settings_t out;
+	boot(&out);
+
+	const uint32_t total = 70000;
+	uint32_t wrong = 0;
+
+	for (uint32_t n = 1; n <= total; n++) {
+		settings_t v = make_values(n);
+		save(&v);
+
+		// reboot around the wrap and now and then
+		if ((n >= 65530 && n <= 65540) || n % 5000 == 0) {
+			if (!boot(&out) || !same(&out, &v)) wrong++;
+		}
+	}
+	CHECK_EQ(wrong, 0);
+
+	settings_t v = make_values(total);
+	CHECK(boot(&out));
+	CHECK(same(&out, &v));
+
+	// both pages wear evenly
+	int32_t diff = (int32_t) flash_emu_erase_count(0) - (int32_t) flash_emu_erase_count(1);
+	CHECK(diff >= -1 && diff <= 1);
+	CHECK(flash_emu_erase_count(0) >= total / (2 * RECORDS_PER_PAGE) - 1);
+}
+
+/** Garbage in the unnamed bitfield bits: the same values are not written again */
+static void test_padding_bits(void)
+{
+	flash_emu_init();
+	settings_t out;
+	boot(&out);
+
+	settings_t a = make_values(7);
+	save(&a);
+	CHECK_EQ(used_slots(0), 1);
+
+	settings_t b;
+	memset(&b, 0xFF, sizeof(b));
+	b.y_scale = a.y_scale;
+	b.brightness = a.brightness;
+	b.render_mode = a.render_mode;
+	b.capture_preset = a.capture_preset;
+	b.fft_size = a.fft_size;
+	b.db_scale = a.db_scale;
+	save(&b);
+	CHECK_EQ(used_slots(0), 1);
+
+	CHECK(boot(&out));
+	CHECK(same(&out, &a));
+}
+
+/** A load of an empty store forgets the sequence number of an earlier load */
+static void test_reload_seq(void)
+{
+	flash_emu_init();
+	settings_t out;
+	boot(&out);
+
+	for (uint32_t n = 0; n < 3; n++) {
+		settings_t v = make_values(n + 300);
+		save(&v);
+	}
+	CHECK(boot(&out));
+
+	flash_emu_init();
+	CHECK(!boot(&out));
+
+	settings_t v = make_values(400);
+	save(&v);
+	const uint8_t *rec = flash_emu_page(0);
+	CHECK_EQ(rec[2] | rec[3] << 8, 1); // seq
+}
+
+int main(void)
+{
+	test_empty();
+	test_deferred_save();
+	test_torn_record();
+	test_both_pages_full();
+	test_torn_erase();
+	test_seq_wrap();
+	test_padding_bits();
+	test_reload_seq();
+
+	return test_summary();
+}
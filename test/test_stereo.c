@@ -0,0 +1,66 @@
+#include <string.h>
+#include "test.h"
+#include "stereo.h"
+#include "capture.h"
+
+// Correlation meter at full scale, where 32-bit products overflow
+
+#define N 256
+
+static uint32_t buf[N];
+
+static uint32_t pair(uint16_t l, uint16_t r)
+{
+	return ((uint32_t) r << 16) | l;
+}
+
+/** Rare full-scale spikes: the mean is near 0, the deviations near 65535 */
+static void fill_spikes(bool invert_r)
+{
+	for (uint32_t i = 0; i < N; i++) {
+		uint16_t v = (i % 64 == 0) ? 0xFFFF : 0;
+		buf[i] = pair(v, invert_r ? (uint16_t) (0xFFFF - v) : v);
+	}
+}
+
+static void test_spikes(void)
+{
+	fill_spikes(false);
+	CHECK_NEAR(stereo_correlation(buf, N), 1.0, 1e-4);
+
+	fill_spikes(true);
+	CHECK_NEAR(stereo_correlation(buf, N), -1.0, 1e-4);
+}
+
+static void test_square(void)
+{
+	for (uint32_t i = 0; i < N; i++) {
+		uint16_t v = (i & 8) ? 0xFFFF : 0;
+		buf[i] = pair(v, (uint16_t) (0xFFFF - v));
+	}
+	CHECK_NEAR(stereo_correlation(buf, N), -1.0, 1e-4);
+
+	// uncorrelated: the right channel at a quarter period offset
+	for (uint32_t i = 0; i < N; i++) {
+		buf[i] = pair((i & 8) ? 0xFFFF : 0, ((i + 4) & 8) ? 0xFFFF : 0);
+	}
+	CHECK_NEAR(stereo_correlation(buf, N), 0.0, 1e-4);
+}
+
+static void test_silence(void)
+{
+	for (uint32_t i = 0; i < N; i++) {
+		buf[i] = pair(0x8000, 0x8000);
+	}
+	CHECK_EQ(stereo_correlation(buf, N), 0);
+	CHECK_EQ(stereo_correlation(buf, 0), 0);
+}
+
+int main(void)
+{
+	test_spikes();
+	test_square();
+	test_silence();
+
+	return test_summary();
+}
@@ -0,0 +1,104 @@
+#include <string.h>
+#include <math.h>
+#include <stdbool.h>
+#include "test.h"
+#include "dsp.h"
+#include "bands.h"
+#include "onset.h"
+#include "tempo.h"
+#include "drum_synth.h"
+
+// Tempo estimate on labelled drum loops, frames timed by the sample clock
+
+#define SAMPLE_RATE 20000.0f
+#define DURATION_MS 12000
+#define TOTAL 240000 // SAMPLE_RATE * DURATION_MS
+
+/** Spectrum gain of the beat mode (FFT_SCALE * default y_scale in user_main.c) */
+#define GAIN (0.25f * 0.3f / 16 * 5)
+
+/** Allowed BPM error; a 20 ms slot is 3 % of a beat at 90 BPM, interpolated */
+#define BPM_TOL 0.03f
+
+static uint32_t audio[TOTAL];
+static uint32_t frame[FFT_MAX_LEN * 2];
+
+/** Samples missed between frames while the last one renders, as in test_onset */
+static uint32_t gap_samples(uint32_t frame_index)
+{
+	return (frame_index * 37) % 61;
+}
+
+/** Run onset and tempo over the rendered audio like calculate_fft(), return the final BPM */
+static float run(const fft_config_t *cfg)
+{
+	float levels[BAND_COUNT];
+
+	onset_reset();
+	tempo_reset();
+	bands_configure(SAMPLE_RATE, cfg->fft_len);
+
+	uint32_t pos = 0;
+	for (uint32_t f = 0; pos + cfg->fft_len <= TOTAL; f++) {
+		memcpy(frame, audio + pos, cfg->fft_len * sizeof(uint32_t));
+		dsp_spectrum(frame, cfg, GAIN, MAG_SQUARED);
+		bands_compute((const float *) frame, levels);
+		for (int b = 0; b < BAND_COUNT; b++) levels[b] = sqrtf(levels[b]);
+
+		pos += cfg->fft_len;
+		const ms_time_t now = (ms_time_t) (pos * 1000.0f / SAMPLE_RATE);
+		onset_process(levels, now);
+		tempo_process(onset_strength(), now);
+
+		pos += gap_samples(f);
+	}
+
+	return tempo_bpm();
+}
+
+/** True if a kick or a snare falls on every beat */
+static bool accents_on_beats(const drum_loop_t *loop)
+{
+	for (uint32_t step = 0; step < DRUM_STEPS; step += 4) {
+		if (loop->kick[step] != 'x' && loop->snare[step] != 'x') return false;
+	}
+	return true;
+}
+
+/**
+ * Every loop's tempo at 64..256 points. At 512 and 1024 the hats aren't
+ * detected (see test_onset), the tempo is only checked for loops with a kick
+ * or snare on every beat: the halftime loop's 0, 8, 11 steps have no period
+ * in the BPM range without them.
+ */
+static void test_loops(void)
+{
+	for (uint32_t i = 0; i < drum_loop_count; i++) {
+		const drum_loop_t *loop = &drum_loops[i];
+		drum_render(loop, SAMPLE_RATE, audio, TOTAL);
+
+		for (uint32_t c = 0; c < FFT_CONFIG_COUNT; c++) {
+			const fft_config_t *cfg = fft_config_get(c);
+			if (cfg->fft_len >= 512 && !accents_on_beats(loop)) continue;
+			const float bpm = run(cfg);
+
+			printf("%-18s %4u: %6.1f BPM, labelled %.0f\n", loop->name, cfg->fft_len, bpm, loop->bpm);
+			CHECK_NEAR(bpm / loop->bpm, 1.0f, BPM_TOL);
+		}
+	}
+}
+
+/** No beat in silence */
+static void test_silence(void)
+{
+	for (uint32_t i = 0; i < TOTAL; i++) audio[i] = 32768;
+	CHECK_EQ(run(fft_config_get(FFT_CONFIG_DEFAULT)), 0);
+}
+
+int main(void)
+{
+	test_loops();
+	test_silence();
+
+	return test_summary();
+}